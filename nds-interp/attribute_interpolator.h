@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "slope.h"
+
+/// <summary>
+/// Linearly interpolates a set of vertex attributes (such as depth, color and texture coordinates) between two
+/// endpoints using the same fixed-point conventions as Slope.
+/// </summary>
+/// <remarks>
+/// The interpolator works along a single coordinate: the Y coordinate when interpolating along a polygon edge, or the
+/// X coordinate when interpolating across a span between the attributes of its left and right edges.
+///
+/// As with Slope, the values carry Slope::kFracBits fractional bits, and the increment per unit of the coordinate is
+/// computed by taking the reciprocal of the coordinate delta first and then multiplying it by the attribute delta:
+///
+///    Step = 1 / (C1 - C0) * (A1 - A0)
+///    A = (C - C0) * Step + A0
+///
+/// The results are truncated to integers. Attribute deltas are wider than X coordinate deltas (depth values in
+/// particular span the full 24-bit range), so the intermediates are 64-bit to avoid any overflow.
+///
+/// All attributes are stored in separate arrays and computed with the same operations, so the loops over the
+/// attributes are straightforward to vectorize.
+/// </remarks>
+/// <typeparam name="N">The number of attributes</typeparam>
+template <size_t N>
+class AttributeInterpolator {
+    using u32 = uint32_t;
+    using i32 = int32_t;
+    using i64 = int64_t;
+
+public:
+    /// <summary>
+    /// A set of attribute values.
+    /// </summary>
+    using Values = std::array<i32, N>;
+
+    /// <summary>
+    /// The number of fractional bits of the interpolator, identical to that of Slope.
+    /// </summary>
+    static constexpr u32 kFracBits = Slope::kFracBits;
+
+    /// <summary>
+    /// Configures the interpolator to interpolate from the attributes A0 at coordinate C0 to the attributes A1 at
+    /// coordinate C1.
+    /// </summary>
+    /// <remarks>
+    /// If both coordinates are equal, every coordinate evaluates to A0.
+    /// </remarks>
+    /// <param name="c0">First coordinate</param>
+    /// <param name="c1">Second coordinate</param>
+    /// <param name="a0">Attributes at the first coordinate</param>
+    /// <param name="a1">Attributes at the second coordinate</param>
+    constexpr void Setup(i32 c0, i32 c1, const Values &a0, const Values &a1) {
+        // Always interpolate towards increasing coordinates
+        const Values *start = &a0;
+        const Values *end = &a1;
+        if (c1 < c0) {
+            std::swap(c0, c1);
+            std::swap(start, end);
+        }
+
+        // Compute the reciprocal first; this ensures the division is performed before the multiplication
+        m_c0 = c0;
+        const i64 reciprocal = Slope::Reciprocal(c1 - c0);
+        for (size_t i = 0; i < N; i++) {
+            m_start[i] = (i64)(*start)[i] * Slope::kOne;
+            m_step[i] = ((i64)(*end)[i] - (*start)[i]) * reciprocal;
+        }
+    }
+
+    /// <summary>
+    /// Computes the attributes at the specified coordinate.
+    /// </summary>
+    /// <param name="c">The coordinate, which should be between C0 and C1 specified in Setup</param>
+    /// <param name="out">Receives the attributes</param>
+    constexpr void Evaluate(i32 c, Values &out) const {
+        const i64 offset = c - m_c0;
+        for (size_t i = 0; i < N; i++) {
+            out[i] = (i32)((m_start[i] + offset * m_step[i]) >> kFracBits);
+        }
+    }
+
+    /// <summary>
+    /// Computes the attributes at the specified coordinate.
+    /// </summary>
+    /// <param name="c">The coordinate, which should be between C0 and C1 specified in Setup</param>
+    /// <returns>The attributes</returns>
+    constexpr Values Evaluate(i32 c) const {
+        Values out{};
+        Evaluate(c, out);
+        return out;
+    }
+
+    /// <summary>
+    /// Computes the attributes of a range of consecutive coordinates, such as every pixel of a span.
+    /// </summary>
+    /// <remarks>
+    /// The attributes at coordinate c0+i are written to out[i], producing the same values as Evaluate(c0+i). The
+    /// array must have room for at least c1-c0 elements.
+    /// </remarks>
+    /// <param name="c0">The first coordinate</param>
+    /// <param name="c1">The coordinate past the last coordinate</param>
+    /// <param name="out">The array that receives the attributes</param>
+    constexpr void Generate(i32 c0, i32 c1, Values *out) const {
+        std::array<i64, N> values{};
+        const i64 offset = c0 - m_c0;
+        for (size_t i = 0; i < N; i++) {
+            values[i] = m_start[i] + offset * m_step[i];
+        }
+        for (i32 c = c0; c < c1; c++, out++) {
+            for (size_t i = 0; i < N; i++) {
+                (*out)[i] = (i32)(values[i] >> kFracBits);
+                values[i] += m_step[i];
+            }
+        }
+    }
+
+private:
+    std::array<i64, N> m_start; // Attributes at C0, with fractional bits
+    std::array<i64, N> m_step;  // Attribute increments per unit of the coordinate, with fractional bits
+    i32 m_c0;                   // C0 coordinate
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "attribute_interpolator.h"
+#include "rasterizer.h"
+
+/// <summary>
+/// Rasterizes convex polygons like Rasterizer while interpolating a set of vertex attributes along the edges.
+/// </summary>
+/// <remarks>
+/// Setup configures an AttributeInterpolator for every edge next to its Slope. Rasterize walks the edges once and, on
+/// every scanline, computes the attributes of the left and right edges in the same pass as the span itself, so no edge
+/// is walked more than once. The attributes across a span are then interpolated between the two with another
+/// AttributeInterpolator:
+///
+///    AttributeInterpolator&lt;N&gt; across;
+///    across.Setup(span.xStart, span.xEnd, left[i], right[i]);
+///    across.Generate(span.xStart, span.xEnd + 1, pixels);
+///
+/// The edge attributes are interpolated along the Y coordinate. Perspective correction is not applied.
+/// </remarks>
+/// <typeparam name="N">The number of attributes per vertex</typeparam>
+template <size_t N>
+class AttributeRasterizer : private Rasterizer {
+    using i32 = int32_t;
+
+public:
+    using Rasterizer::kMaxVertices;
+    using Rasterizer::kScreenHeight;
+    using Rasterizer::kScreenWidth;
+    using Rasterizer::Span;
+    using Rasterizer::SpanList;
+    using Rasterizer::Vertex;
+
+    /// <summary>
+    /// A set of attribute values.
+    /// </summary>
+    using Values = typename AttributeInterpolator<N>::Values;
+
+    /// <summary>
+    /// Prepares a convex polygon and its vertex attributes for rasterization.
+    /// </summary>
+    /// <param name="vertices">The vertices of the polygon, in order</param>
+    /// <param name="attributes">The attributes of each vertex</param>
+    /// <param name="count">The number of vertices, between 3 and kMaxVertices</param>
+    /// <returns>true if the polygon was prepared, false if the number of vertices is not supported</returns>
+    bool Setup(const Vertex *vertices, const Values *attributes, size_t count) {
+        if (!Rasterizer::Setup(vertices, count)) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const size_t next = (i + 1 < count) ? (i + 1) : 0;
+            m_attributes[i].Setup(vertices[i].y, vertices[next].y, attributes[i], attributes[next]);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Rasterizes the scanlines of the polygon within the specified range, computing the spans and the attributes of
+    /// their left and right edges.
+    /// </summary>
+    /// <remarks>
+    /// The spans are identical to those produced by Rasterizer::Rasterize. The attributes of the edges on each side of
+    /// spans[i] are written to left[i] and right[i]; all three arrays must have room for capacity elements.
+    /// </remarks>
+    /// <param name="y0">The first scanline of the range</param>
+    /// <param name="y1">The scanline past the last scanline of the range</param>
+    /// <param name="spans">The buffer that receives the spans</param>
+    /// <param name="left">The buffer that receives the attributes of the left edge of each span</param>
+    /// <param name="right">The buffer that receives the attributes of the right edge of each span</param>
+    /// <param name="capacity">The maximum number of spans to write</param>
+    /// <returns>The number of spans written</returns>
+    size_t Rasterize(i32 y0, i32 y1, Span *spans, Values *left, Values *right, size_t capacity) const {
+        return Walk(y0, y1, capacity, [&](const Span &span, size_t leftEdge, size_t rightEdge) {
+            m_attributes[leftEdge].Evaluate(span.y, *left++);
+            m_attributes[rightEdge].Evaluate(span.y, *right++);
+            *spans++ = span;
+        });
+    }
+
+    /// <summary>
+    /// Rasterizes the polygon, computing the spans and the attributes of their left and right edges.
+    /// </summary>
+    /// <param name="spans">The buffer that receives the spans</param>
+    /// <param name="left">The buffer that receives the attributes of the left edge of each span</param>
+    /// <param name="right">The buffer that receives the attributes of the right edge of each span</param>
+    /// <param name="capacity">The maximum number of spans to write</param>
+    /// <returns>The number of spans written</returns>
+    size_t Rasterize(Span *spans, Values *left, Values *right, size_t capacity) const {
+        return Rasterize(0, kScreenHeight, spans, left, right, capacity);
+    }
+
+    using Rasterizer::Bottom;
+    using Rasterizer::Rasterize;
+    using Rasterizer::Top;
+
+private:
+    std::array<AttributeInterpolator<N>, kMaxVertices> m_attributes; // Attributes along each edge
+};
@@ -0,0 +1,555 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "attribute_rasterizer.h"
+#include "frame_arena.h"
+#include "parallel.h"
+#include "rasterizer.h"
+#include "slope.h"
+#include "slope_batch.h"
+#include "slope_simd.h"
+#include "span_cache.h"
+#include "span_lut.h"
+
+using u64 = uint64_t;
+using i32 = int32_t;
+
+namespace {
+
+// Number of edges in each distribution
+constexpr size_t kNumEdges = 4096;
+
+// Minimum duration of each measurement
+constexpr std::chrono::milliseconds kMinDuration{200};
+
+struct Edge {
+    i32 x0, y0, x1, y1;
+    i32 top, bottom; // Scanlines covered by the edge (top inclusive, bottom exclusive)
+};
+
+struct Distribution {
+    std::string name;
+    std::vector<Edge> edges;
+    size_t spans; // Total number of scanlines of all edges
+};
+
+// Prevents the compiler from optimizing away the benchmarked code
+volatile i32 g_sink;
+
+Edge makeEdge(i32 x0, i32 y0, i32 x1, i32 y1) {
+    i32 top = std::min(y0, y1);
+    i32 bottom = std::max(y0, y1);
+    if (top == bottom) bottom++;
+    return {x0, y0, x1, y1, top, bottom};
+}
+
+// Generates edges from random origins on the screen with deltas within the specified ranges, optionally mirrored
+// horizontally (negative slopes)
+template <typename Generator>
+std::vector<Edge> randomEdges(Generator &gen, i32 minDX, i32 maxDX, i32 minDY, i32 maxDY, bool negative) {
+    std::uniform_int_distribution<i32> distDX{minDX, maxDX};
+    std::uniform_int_distribution<i32> distDY{minDY, maxDY};
+    std::vector<Edge> edges;
+    edges.reserve(kNumEdges);
+    while (edges.size() < kNumEdges) {
+        const i32 dx = distDX(gen);
+        const i32 dy = distDY(gen);
+        const i32 x0 = std::uniform_int_distribution<i32>{0, 256 - dx}(gen);
+        const i32 y0 = std::uniform_int_distribution<i32>{0, 192 - dy}(gen);
+        if (negative) {
+            edges.push_back(makeEdge(x0 + dx, y0, x0, y0 + dy));
+        } else {
+            edges.push_back(makeEdge(x0, y0, x0 + dx, y0 + dy));
+        }
+    }
+    return edges;
+}
+
+std::vector<Distribution> makeDistributions() {
+    std::mt19937 gen{12345};
+    std::vector<Distribution> dists;
+
+    auto add = [&](std::string name, std::vector<Edge> edges) {
+        size_t spans = 0;
+        for (auto &edge : edges) {
+            spans += edge.bottom - edge.top;
+        }
+        dists.push_back({std::move(name), std::move(edges), spans});
+    };
+
+    add("X-major positive", randomEdges(gen, 33, 256, 1, 32, false));
+    add("X-major negative", randomEdges(gen, 33, 256, 1, 32, true));
+    add("Y-major positive", randomEdges(gen, 1, 32, 33, 192, false));
+    add("Y-major negative", randomEdges(gen, 1, 32, 33, 192, true));
+    add("Short (<= 8x8)", randomEdges(gen, 0, 8, 0, 8, false));
+    add("Full-screen", randomEdges(gen, 192, 256, 160, 192, false));
+
+    // Mixed orientations in random order, then the same edges sorted by orientation
+    std::vector<Edge> mixed;
+    for (size_t i = 0; i < kNumEdges / 4; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            mixed.push_back(dists[j].edges[i]);
+        }
+    }
+    std::shuffle(mixed.begin(), mixed.end(), gen);
+    add("Mixed, random order", mixed);
+
+    std::stable_sort(mixed.begin(), mixed.end(), [](const Edge &lhs, const Edge &rhs) {
+        auto key = [](const Edge &edge) {
+            Slope slope;
+            slope.Setup(edge.x0, edge.y0, edge.x1, edge.y1);
+            return slope.IsNegative() * 2 + slope.IsXMajor();
+        };
+        return key(lhs) < key(rhs);
+    });
+    add("Mixed, sorted", mixed);
+
+    return dists;
+}
+
+// Runs the function repeatedly for at least kMinDuration and returns the average duration of one run in nanoseconds
+double measure(const std::function<void()> &fn) {
+    using Clock = std::chrono::steady_clock;
+
+    fn(); // Warm up caches and branch predictors
+    size_t runs = 0;
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    do {
+        fn();
+        runs++;
+        elapsed = Clock::now() - start;
+    } while (elapsed < kMinDuration);
+    return std::chrono::duration<double, std::nano>(elapsed).count() / runs;
+}
+
+void printHeader(const char *title, const char *unit, const std::vector<Distribution> &dists) {
+    std::cout << "\n" << title << " (" << unit << ")\n";
+    std::cout << std::setw(24) << "";
+    for (auto &dist : dists) {
+        std::cout << std::setw(22) << dist.name;
+    }
+    std::cout << "\n";
+}
+
+void printRow(const std::string &name, const std::vector<double> &values) {
+    std::cout << std::setw(24) << std::left << name << std::right << std::fixed << std::setprecision(2);
+    for (double value : values) {
+        std::cout << std::setw(22) << value;
+    }
+    std::cout << "\n";
+}
+
+// Benchmarks the setup of every edge of each distribution
+void benchmarkSetup(const std::vector<Distribution> &dists) {
+    printHeader("Setup", "ns/edge", dists);
+
+    std::vector<double> scalar, batch;
+    for (auto &dist : dists) {
+        const auto &edges = dist.edges;
+        // The slopes are stored so that no part of the setup is optimized away
+        std::vector<Slope> slopes(edges.size());
+        const double scalarTime = measure([&] {
+            for (size_t i = 0; i < edges.size(); i++) {
+                auto &edge = edges[i];
+                slopes[i].Setup(edge.x0, edge.y0, edge.x1, edge.y1);
+            }
+            g_sink = slopes.back().FracXEnd(edges.back().top);
+        });
+        scalar.push_back(scalarTime / edges.size());
+
+        std::vector<i32> x0, y0, x1, y1;
+        for (auto &edge : edges) {
+            x0.push_back(edge.x0);
+            y0.push_back(edge.y0);
+            x1.push_back(edge.x1);
+            y1.push_back(edge.y1);
+        }
+        static SlopeBatch<kNumEdges> batchSlopes;
+        const double batchTime = measure([&] {
+            batchSlopes.Setup(x0.data(), y0.data(), x1.data(), y1.data(), edges.size());
+            g_sink = batchSlopes.Get(edges.size() - 1).FracXEnd(edges.back().top);
+        });
+        batch.push_back(batchTime / edges.size());
+    }
+    printRow("Slope::Setup", scalar);
+    printRow("SlopeBatch::Setup", batch);
+}
+
+// Benchmarks span generation over all scanlines of every edge of each distribution. The slopes are set up beforehand.
+void benchmarkSpans(const std::vector<Distribution> &dists) {
+    printHeader("Span generation", "ns/span", dists);
+
+    std::vector<std::vector<Slope>> slopes;
+    for (auto &dist : dists) {
+        auto &distSlopes = slopes.emplace_back(dist.edges.size());
+        for (size_t i = 0; i < dist.edges.size(); i++) {
+            auto &edge = dist.edges[i];
+            distSlopes[i].Setup(edge.x0, edge.y0, edge.x1, edge.y1);
+        }
+    }
+
+    // Measures fn(slope, edge, starts, ends) over every edge of each distribution. The function is inlined into the
+    // measurement loop and must store every span into the buffers, so that all methods do the same observable work.
+    std::vector<i32> startBuffer(256), endBuffer(256);
+    auto run = [&](const std::string &name, auto fn) {
+        std::vector<double> results;
+        for (size_t d = 0; d < dists.size(); d++) {
+            const auto &edges = dists[d].edges;
+            const auto &distSlopes = slopes[d];
+            const double time = measure([&] {
+                i32 sum = 0;
+                for (size_t i = 0; i < edges.size(); i++) {
+                    sum += fn(distSlopes[i], edges[i], startBuffer.data(), endBuffer.data());
+                }
+                g_sink = sum;
+            });
+            results.push_back(time / dists[d].spans);
+        }
+        printRow(name, results);
+    };
+
+    run("FracXStart/FracXEnd", [](const Slope &slope, const Edge &edge, i32 *starts, i32 *ends) {
+        for (i32 y = edge.top; y < edge.bottom; y++) {
+            starts[y - edge.top] = slope.FracXStart(y);
+            ends[y - edge.top] = slope.FracXEnd(y);
+        }
+        return starts[0] ^ ends[0];
+    });
+    run("Stepper", [](const Slope &slope, const Edge &edge, i32 *starts, i32 *ends) {
+        auto stepper = slope.Begin(edge.top);
+        for (i32 y = edge.top; y < edge.bottom; y++, stepper.Next()) {
+            starts[y - edge.top] = stepper.FracXStart();
+            ends[y - edge.top] = stepper.FracXEnd();
+        }
+        return starts[0] ^ ends[0];
+    });
+    run("Oriented stepper", [](const Slope &slope, const Edge &edge, i32 *starts, i32 *ends) {
+        slope.Dispatch([&](auto oriented) {
+            auto stepper = oriented.Begin(edge.top);
+            for (i32 y = edge.top; y < edge.bottom; y++, stepper.Next()) {
+                starts[y - edge.top] = stepper.FracXStart();
+                ends[y - edge.top] = stepper.FracXEnd();
+            }
+        });
+        return starts[0] ^ ends[0];
+    });
+    run("GenerateSpans", [](const Slope &slope, const Edge &edge, i32 *starts, i32 *ends) {
+        slope.GenerateSpans(edge.top, edge.bottom, starts, ends);
+        return starts[0] ^ ends[0];
+    });
+    for (SIMDKernel kernel : {SIMDKernel::SSE41, SIMDKernel::AVX2, SIMDKernel::NEON}) {
+        if (!IsSIMDKernelSupported(kernel)) {
+            continue;
+        }
+        run(std::string("GenerateSpansSIMD ") + SIMDKernelName(kernel),
+            [kernel](const Slope &slope, const Edge &edge, i32 *starts, i32 *ends) {
+                GenerateSpansSIMD(kernel, slope, edge.top, edge.bottom, starts, ends);
+                return starts[0] ^ ends[0];
+            });
+    }
+    // The overload that picks the scalar code or a kernel for each slope, as used by nds_slope_spans
+    run("GenerateSpansSIMD", [](const Slope &slope, const Edge &edge, i32 *starts, i32 *ends) {
+        GenerateSpansSIMD(slope, edge.top, edge.bottom, starts, ends);
+        return starts[0] ^ ends[0];
+    });
+}
+
+// Benchmarks span lookups from the precomputed table, including edge setup, if the table file is available
+void benchmarkLUT(const std::vector<Distribution> &dists) {
+    SpanLUT lut;
+    if (!lut.Open("data/spans.lut")) {
+        std::cout << "\nSkipping span table benchmark: data/spans.lut not found (see SpanLUT::Generate)\n";
+        return;
+    }
+
+    printHeader("Span table setup + lookup", "ns/span", dists);
+    std::vector<double> results;
+    for (auto &dist : dists) {
+        const double time = measure([&] {
+            i32 sum = 0;
+            for (auto &edge : dist.edges) {
+                SpanLUT::Edge lutEdge;
+                lut.Setup(edge.x0, edge.y0, edge.x1, edge.y1, lutEdge);
+                for (i32 y = edge.top; y < edge.bottom; y++) {
+                    sum += lutEdge.XStart(y) ^ lutEdge.XEnd(y);
+                }
+            }
+            g_sink = sum;
+        });
+        results.push_back(time / dist.spans);
+    }
+    printRow("SpanLUT::Edge", results);
+}
+
+// Benchmarks span retrieval from the span cache over frames that repeat the same edges, against setting up the slopes
+// and generating their spans every frame
+void benchmarkCache(const std::vector<Distribution> &dists) {
+    printHeader("Span cache (repeated frames)", "ns/span", dists);
+    std::array<i32, SpanCache::kMaxLines> starts;
+    std::array<i32, SpanCache::kMaxLines> ends;
+    std::vector<double> uncached;
+    std::vector<double> cached;
+    std::vector<double> hitRates;
+    for (auto &dist : dists) {
+        const double uncachedTime = measure([&] {
+            i32 sum = 0;
+            for (auto &edge : dist.edges) {
+                Slope slope;
+                slope.Setup(edge.x0, edge.y0, edge.x1, edge.y1);
+                slope.GenerateSpans(edge.top, edge.bottom, starts.data(), ends.data());
+                sum += starts[0] ^ ends[edge.bottom - edge.top - 1];
+            }
+            g_sink = sum;
+        });
+        uncached.push_back(uncachedTime / dist.spans);
+
+        // Each run draws one frame of the same edges
+        SpanCache cache{kNumEdges * 2};
+        const double cachedTime = measure([&] {
+            i32 sum = 0;
+            for (auto &edge : dist.edges) {
+                SpanCache::Edge cachedEdge;
+                if (cache.Get(edge.x0, edge.y0, edge.x1, edge.y1, cachedEdge)) {
+                    sum += cachedEdge.starts[0] ^ cachedEdge.ends[cachedEdge.lines - 1];
+                }
+            }
+            cache.NextFrame();
+            g_sink = sum;
+        });
+        cached.push_back(cachedTime / dist.spans);
+        hitRates.push_back(cache.HitRate() * 100.0);
+    }
+    printRow("Setup + GenerateSpans", uncached);
+    printRow("SpanCache::Get", cached);
+    printRow("Hit rate (%)", hitRates);
+}
+
+// Benchmarks the iteration over the visible scanlines of large edges that extend past the screen, by skipping the
+// off-screen scanlines one by one and by computing the visible range in Setup
+void benchmarkClipping() {
+    std::cout << "\nClipped iteration of large edges (ns/edge)\n";
+
+    // Endpoints up to four screens away, like those of big polygons surrounding the camera
+    std::mt19937 gen{kNumEdges};
+    std::uniform_int_distribution<i32> distX{-1024, 1279};
+    std::uniform_int_distribution<i32> distY{-768, 959};
+    std::vector<Edge> edges;
+    for (size_t i = 0; i < kNumEdges; i++) {
+        edges.push_back(makeEdge(distX(gen), distY(gen), distX(gen), distY(gen)));
+    }
+
+    constexpr Slope::ClipRect kScreen{0, 0, 256, 192};
+    size_t total = 0;
+    size_t visible = 0;
+    const double skipTime = measure([&] {
+        i32 sum = 0;
+        for (auto &edge : edges) {
+            Slope slope;
+            slope.Setup(edge.x0, edge.y0, edge.x1, edge.y1);
+            for (i32 y = edge.top; y < edge.bottom; y++) {
+                const i32 start = slope.XStart(y);
+                const i32 end = slope.XEnd(y);
+                const i32 left = slope.IsNegative() ? end : start;
+                const i32 right = slope.IsNegative() ? start : end;
+                if (y < kScreen.top || y >= kScreen.bottom || left >= kScreen.right || right < kScreen.left) {
+                    continue;
+                }
+                sum += start ^ end;
+            }
+        }
+        g_sink = sum;
+    });
+    const double clipTime = measure([&] {
+        i32 sum = 0;
+        total = visible = 0;
+        for (auto &edge : edges) {
+            Slope slope;
+            const Slope::VisibleRange range = slope.Setup(edge.x0, edge.y0, edge.x1, edge.y1, kScreen);
+            for (i32 y = range.y0; y < range.y1; y++) {
+                sum += slope.XStart(y) ^ slope.XEnd(y);
+            }
+            total += edge.bottom - edge.top;
+            visible += range.y1 - range.y0;
+        }
+        g_sink = sum;
+    });
+
+    printRow("Skip off-screen lines", {skipTime / edges.size()});
+    printRow("Setup with clip rect", {clipTime / edges.size()});
+    printRow("Visible scanlines (%)", {100.0 * visible / total});
+}
+
+// Benchmarks the rasterization of random on-screen triangles, with and without polygon setup, sequentially and in
+// parallel bands
+void benchmarkRasterizer() {
+    std::mt19937 gen{12345};
+    std::uniform_int_distribution<i32> distX{0, Rasterizer::kScreenWidth - 1};
+    std::uniform_int_distribution<i32> distY{0, Rasterizer::kScreenHeight - 1};
+    std::vector<Rasterizer::Vertex> vertices(kNumEdges * 3);
+    for (auto &vertex : vertices) {
+        vertex = {distX(gen), distY(gen)};
+    }
+
+    std::vector<Rasterizer> polygons(kNumEdges);
+    std::vector<Rasterizer::Span> spans(Rasterizer::kScreenHeight);
+    size_t numSpans = 0;
+    for (size_t i = 0; i < polygons.size(); i++) {
+        polygons[i].Setup(&vertices[i * 3], 3);
+        numSpans += polygons[i].Rasterize(spans.data(), spans.size());
+    }
+
+    const double setupTime = measure([&] {
+        Rasterizer rasterizer;
+        i32 sum = 0;
+        for (size_t i = 0; i < vertices.size(); i += 3) {
+            rasterizer.Setup(&vertices[i], 3);
+            const size_t count = rasterizer.Rasterize(spans.data(), spans.size());
+            sum += (i32)count + spans[0].xStart;
+        }
+        g_sink = sum;
+    });
+    // Seven attributes, as needed for depth, vertex colors and texture coordinates
+    using AttributeValues = AttributeRasterizer<7>::Values;
+    std::uniform_int_distribution<i32> distAttribute{0, (1 << 24) - 1};
+    std::vector<AttributeValues> attributes(vertices.size());
+    for (auto &values : attributes) {
+        for (auto &value : values) {
+            value = distAttribute(gen);
+        }
+    }
+    std::vector<AttributeValues> left(spans.size()), right(spans.size());
+    const double attributesTime = measure([&] {
+        AttributeRasterizer<7> rasterizer;
+        i32 sum = 0;
+        for (size_t i = 0; i < vertices.size(); i += 3) {
+            rasterizer.Setup(&vertices[i], &attributes[i], 3);
+            const size_t count = rasterizer.Rasterize(spans.data(), left.data(), right.data(), spans.size());
+            sum += (i32)count + spans[0].xStart + left[0][0] + right[0][6];
+        }
+        g_sink = sum;
+    });
+    const double preparedTime = measure([&] {
+        i32 sum = 0;
+        for (auto &polygon : polygons) {
+            const size_t count = polygon.Rasterize(spans.data(), spans.size());
+            sum += (i32)count + spans[0].xStart;
+        }
+        g_sink = sum;
+    });
+    WorkerPool pool;
+    const double bandsTime = measure([&] {
+        std::array<i32, Rasterizer::kScreenHeight> sums{};
+        RasterizeBands(pool, polygons.data(), polygons.size(),
+                       [&](size_t, const Rasterizer::Span *bandSpans, size_t count) {
+                           sums[bandSpans[0].y] += (i32)count + bandSpans[0].xStart;
+                       });
+        g_sink = sums[0];
+    });
+
+    std::cout << "\nRasterizer (random triangles)\n";
+    std::cout << std::setw(24) << "" << std::setw(22) << "ns/triangle" << std::setw(22) << "ns/span" << "\n";
+    auto print = [&](const std::string &name, double time) {
+        printRow(name, {time / polygons.size(), time / numSpans});
+    };
+    print("Setup + Rasterize", setupTime);
+    print("AttributeRasterizer<7>", attributesTime);
+    print("Rasterize", preparedTime);
+    print("RasterizeBands x" + std::to_string(pool.Size()), bandsTime);
+}
+
+// Benchmarks storing the spans of a full frame of random on-screen triangles in a container per polygon, allocated
+// every frame, against storing them in a frame arena. Both the average and the spread of the frame times are reported
+// since allocator churn mostly shows up as variance.
+void benchmarkFrameStorage() {
+    constexpr size_t kFrames = 500;
+
+    std::mt19937 gen{54321};
+    std::uniform_int_distribution<i32> distX{0, Rasterizer::kScreenWidth - 1};
+    std::uniform_int_distribution<i32> distY{0, Rasterizer::kScreenHeight - 1};
+    std::vector<Rasterizer> polygons(FrameArena::kMaxPolygons);
+    for (auto &polygon : polygons) {
+        polygon.SetupTriangle({distX(gen), distY(gen)}, {distX(gen), distY(gen)}, {distX(gen), distY(gen)});
+    }
+
+    // Measures the duration of each frame, returning the average, standard deviation and maximum in microseconds
+    auto measureFrames = [&](auto &&frame) -> std::vector<double> {
+        using Clock = std::chrono::steady_clock;
+        frame(); // Warm up caches and branch predictors
+        std::vector<double> times(kFrames);
+        for (auto &time : times) {
+            const auto start = Clock::now();
+            frame();
+            time = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        }
+        double mean = 0.0;
+        for (double time : times) {
+            mean += time;
+        }
+        mean /= kFrames;
+        double variance = 0.0;
+        for (double time : times) {
+            variance += (time - mean) * (time - mean);
+        }
+        return {mean, std::sqrt(variance / kFrames), *std::max_element(times.begin(), times.end())};
+    };
+
+    const auto vectorTimes = measureFrames([&] {
+        std::vector<std::vector<Rasterizer::Span>> frame(polygons.size());
+        i32 sum = 0;
+        for (size_t i = 0; i < polygons.size(); i++) {
+            auto &spans = frame[i];
+            spans.resize(Rasterizer::kScreenHeight);
+            spans.resize(polygons[i].Rasterize(spans.data(), spans.size()));
+            sum += (i32)spans.size();
+        }
+        g_sink = sum;
+    });
+
+    FrameArena arena;
+    std::vector<Rasterizer::SpanList> lists(polygons.size());
+    const auto arenaTimes = measureFrames([&] {
+        arena.Reset();
+        i32 sum = 0;
+        for (size_t i = 0; i < polygons.size(); i++) {
+            polygons[i].Rasterize(arena, lists[i]);
+            sum += (i32)lists[i].count;
+        }
+        g_sink = sum;
+    });
+
+    std::cout << "\nFrame storage (" << polygons.size() << " random triangles per frame)\n";
+    std::cout << std::setw(24) << "" << std::setw(22) << "us/frame" << std::setw(22) << "stddev" << std::setw(22)
+              << "max" << "\n";
+    printRow("std::vector per polygon", vectorTimes);
+    printRow("FrameArena", arenaTimes);
+    std::cout << "Arena peak usage: " << arena.Peak() / 1024 << " KB of " << arena.Capacity() / 1024 << " KB\n";
+}
+
+} // namespace
+
+void runBenchmarks() {
+    std::cout << "Generating edge distributions... ";
+    const auto dists = makeDistributions();
+    std::cout << "OK\n";
+    std::cout << "Best SIMD kernel: " << SIMDKernelName(DetectSIMDKernel()) << "\n";
+
+    benchmarkSetup(dists);
+    benchmarkSpans(dists);
+    benchmarkLUT(dists);
+    benchmarkCache(dists);
+    benchmarkClipping();
+    benchmarkRasterizer();
+    benchmarkFrameStorage();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/// <summary>
+/// Runs the slope setup and span generation microbenchmarks and prints the results.
+/// </summary>
+/// <remarks>
+/// Every benchmark runs over several edge distributions (X-major vs. Y-major, positive vs. negative, short vs.
+/// full-screen, random vs. sorted order) and reports nanoseconds per edge for setup and nanoseconds per span for span
+/// generation. Build with optimizations enabled for meaningful numbers.
+/// </remarks>
+void runBenchmarks();
@@ -0,0 +1,373 @@
+#include "capture_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include "parallel.h"
+#include "slope.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'N', 'D', 'S', 'C'};
+
+// Size of the header of a raw capture file
+constexpr size_t kRawHeaderSize = 7;
+
+// Header of a raw capture file
+struct RawHeader {
+    uint8_t type;
+    int32_t minX, maxX;
+    int32_t minY, maxY;
+};
+
+void WriteU32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)(value >> 0);
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+uint32_t ReadU32(const uint8_t *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+bool ParseHeader(const uint8_t *bytes, RawHeader &header) {
+    header.type = bytes[0];
+    header.minX = bytes[1] | (bytes[2] << 8);
+    header.maxX = bytes[3] | (bytes[4] << 8);
+    header.minY = bytes[5];
+    header.maxY = bytes[6];
+    return header.type <= 3 && header.maxX <= 256 && header.maxY <= 192;
+}
+
+// Computes the scanlines captured in the record of a slope, which cover its bounding box
+std::pair<int32_t, int32_t> RecordLines(const RawHeader &header, int32_t slopeY) {
+    const int32_t first = (header.type & 2) ? std::min(slopeY, 191) : 0;
+    const int32_t last = (header.type & 2) ? 191 : std::min(slopeY, 191);
+    return {first, last - first + 1};
+}
+
+// Computes the number of rows of records in a raw file. Records are grouped by the iteration of the outer loop of the
+// generator that writes them, with the last row also holding the final record.
+int32_t RowCount(const RawHeader &header) {
+    return std::max(header.maxY - header.minY + 1, 1);
+}
+
+// Invokes fn(slopeX, slopeY, hasCoordinates) for each record in a row of a raw file in order, stopping if fn returns
+// false. Returns false if stopped.
+template <typename Fn>
+bool ForEachRecordInRow(const RawHeader &header, int32_t row, Fn &&fn) {
+    const int32_t y = header.minY + row;
+    if (y <= header.maxY) {
+        for (int32_t x = header.minX; x <= header.maxX; x++) {
+            // Each record holds the slope of the previous iteration, starting from (0, 0)
+            int32_t prevX = x - 1;
+            int32_t prevY = y;
+            if (x == header.minX) {
+                prevX = (row == 0) ? 0 : header.maxX;
+                prevY = (row == 0) ? 0 : (y - 1);
+            }
+            if (!fn(prevX, prevY, true)) {
+                return false;
+            }
+        }
+    }
+
+    if (row == RowCount(header) - 1) {
+        // The last record has no coordinates
+        const bool looped = (header.minY <= header.maxY && header.minX <= header.maxX);
+        return fn(looped ? header.maxX : 0, looped ? header.maxY : 0, false);
+    }
+    return true;
+}
+
+// Computes the size of each row of records in a raw file
+std::vector<size_t> RawRowSizes(const RawHeader &header) {
+    std::vector<size_t> sizes(RowCount(header));
+    for (int32_t row = 0; row < (int32_t)sizes.size(); row++) {
+        ForEachRecordInRow(header, row, [&](int32_t, int32_t slopeY, bool hasCoordinates) {
+            sizes[row] += (hasCoordinates ? 2 : 0) + (size_t)RecordLines(header, slopeY).second * 3;
+            return true;
+        });
+    }
+    return sizes;
+}
+
+// Computes the expected (exists, start, end) triplets of scanlines firstLine..firstLine+count-1 of a slope.
+//
+// The spans are captured within the bounding box of the slope, clipped to the screen. Spans extending past the box are
+// clipped to it, and scanlines without a span hold the bounds of the box.
+void Predict(const RawHeader &header, int32_t slopeX, int32_t slopeY, int32_t firstLine, int32_t count,
+             uint8_t *out) {
+    const uint8_t left = (header.type & 1) ? (uint8_t)std::min(slopeX, 255) : 0;
+    const uint8_t right = (header.type & 1) ? 255 : (uint8_t)std::min(slopeX, 255);
+    for (int32_t i = 0; i < count; i++) {
+        out[i * 3 + 0] = 0;
+        out[i * 3 + 1] = left;
+        out[i * 3 + 2] = right;
+    }
+
+    // Always rasterize top to bottom
+    int32_t x0 = (header.type & 1) ? 256 : 0;
+    int32_t y0 = (header.type & 2) ? 192 : 0;
+    int32_t x1 = slopeX;
+    int32_t y1 = slopeY;
+    if (y0 > y1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    // Y0 coinciding with Y1 is equivalent to Y0 and Y1 being 1 pixel apart
+    if (y0 == y1) y1++;
+
+    const int32_t begin = std::max(y0, firstLine);
+    const int32_t end = std::min(y1, firstLine + count);
+    if (begin >= end) {
+        return;
+    }
+
+    Slope slope;
+    slope.Setup(x0, y0, x1, y1);
+
+    std::array<int32_t, 192> starts;
+    std::array<int32_t, 192> ends;
+    slope.GenerateSpans(begin, end, starts.data(), ends.data());
+    for (int32_t y = begin; y < end; y++) {
+        int32_t start = starts[y - begin];
+        int32_t stop = ends[y - begin];
+
+        // Spans are reversed when the slope is negative
+        if (slope.IsNegative()) {
+            std::swap(start, stop);
+        }
+
+        start = std::max(start, (int32_t)left);
+        stop = std::min(stop, (int32_t)right);
+        if (start <= stop) {
+            uint8_t *span = &out[(y - firstLine) * 3];
+            span[0] = 1;
+            span[1] = (uint8_t)start;
+            span[2] = (uint8_t)stop;
+        }
+    }
+}
+
+// Encodes the spans of a record as exceptions against the prediction
+void EncodeSpans(const uint8_t *spans, const uint8_t *predicted, int32_t count, std::vector<uint8_t> &out) {
+    int32_t line = 0;
+    while (true) {
+        // Count the scanlines that match the prediction
+        uint8_t skip = 0;
+        while (line < count && skip < 255 && std::memcmp(&spans[line * 3], &predicted[line * 3], 3) == 0) {
+            line++;
+            skip++;
+        }
+        out.push_back(skip);
+        if (line == count) {
+            return;
+        }
+
+        // Store the bytes of the next scanline that differ from the prediction
+        const size_t flagsPos = out.size();
+        out.push_back(0);
+        for (int i = 0; i < 3; i++) {
+            if (spans[line * 3 + i] != predicted[line * 3 + i]) {
+                out[flagsPos] |= 1 << i;
+                out.push_back(spans[line * 3 + i]);
+            }
+        }
+        line++;
+    }
+}
+
+// Applies the exceptions of a record to its predicted spans, advancing in past the encoded record. Returns false if
+// the encoded record is malformed.
+bool DecodeSpans(const uint8_t *&in, const uint8_t *end, int32_t count, uint8_t *spans) {
+    int32_t line = 0;
+    while (true) {
+        if (in == end) {
+            return false;
+        }
+        line += *in++;
+        if (line > count) {
+            return false;
+        }
+        if (line == count) {
+            return true;
+        }
+
+        if (in == end || (*in & ~7) != 0) {
+            return false;
+        }
+        const uint8_t flags = *in++;
+        for (int i = 0; i < 3; i++) {
+            if (flags & (1 << i)) {
+                if (in == end) {
+                    return false;
+                }
+                spans[line * 3 + i] = *in++;
+            }
+        }
+        line++;
+    }
+}
+
+// Location of every row of records in a compressed file and in the raw file it decompresses to
+struct Layout {
+    RawHeader header;
+    int32_t rows = 0;
+    std::vector<size_t> rawOffsets; // Offset of each row in the raw file
+    std::vector<size_t> offsets;    // Offset of each row in the compressed file
+    size_t rawEnd = 0;              // Offset past the last row in the raw file
+    size_t end = 0;                 // Offset past the last row in the compressed file
+    size_t rawSize = 0;             // Size of the raw file
+};
+
+// Parses the header of a compressed file and locates its rows, ensuring the sizes are consistent
+bool LocateRows(const uint8_t *data, size_t size, Layout &layout) {
+    if (size < CaptureCodec::kHeaderSize || !CaptureCodec::IsCompressed(data, size) ||
+        ReadU32(data + 4) != CaptureCodec::kVersion || ReadU32(data + 8) != Slope::kFracBits) {
+        return false;
+    }
+    if (!ParseHeader(data + 16, layout.header)) {
+        return false;
+    }
+    const int32_t rows = RowCount(layout.header);
+    if (ReadU32(data + 23) != (uint32_t)rows || size - CaptureCodec::kHeaderSize < (size_t)rows * 4) {
+        return false;
+    }
+
+    const std::vector<size_t> rawSizes = RawRowSizes(layout.header);
+    layout.rows = rows;
+    layout.rawOffsets.resize(rows);
+    layout.offsets.resize(rows);
+    layout.rawEnd = kRawHeaderSize;
+    layout.end = CaptureCodec::kHeaderSize + (size_t)rows * 4;
+    for (int32_t row = 0; row < rows; row++) {
+        layout.rawOffsets[row] = layout.rawEnd;
+        layout.offsets[row] = layout.end;
+        layout.rawEnd += rawSizes[row];
+        layout.end += ReadU32(data + CaptureCodec::kHeaderSize + row * 4);
+        if (layout.end > size) {
+            return false;
+        }
+    }
+    layout.rawSize = ReadU32(data + 12);
+    return layout.rawSize >= layout.rawEnd && layout.rawSize - layout.rawEnd == size - layout.end;
+}
+
+// Decodes a row of a compressed file located by LocateRows into its raw bytes
+bool DecodeRow(const uint8_t *data, const Layout &layout, int32_t row, uint8_t *pos) {
+    const uint8_t *in = data + layout.offsets[row];
+    const uint8_t *inEnd = (row + 1 < layout.rows) ? data + layout.offsets[row + 1] : data + layout.end;
+    const RawHeader &header = layout.header;
+    const bool valid = ForEachRecordInRow(header, row, [&](int32_t slopeX, int32_t slopeY, bool hasCoordinates) {
+        if (hasCoordinates) {
+            *pos++ = (uint8_t)slopeX;
+            *pos++ = (uint8_t)slopeY;
+        }
+
+        const auto [firstLine, count] = RecordLines(header, slopeY);
+        Predict(header, slopeX, slopeY, firstLine, count, pos);
+        if (!DecodeSpans(in, inEnd, count, pos)) {
+            return false;
+        }
+        pos += count * 3;
+        return true;
+    });
+    return valid && in == inEnd;
+}
+
+} // namespace
+
+bool CaptureCodec::IsCompressed(const u8 *data, size_t size) {
+    return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool CaptureCodec::Compress(const u8 *data, size_t size, std::vector<u8> &out) {
+    RawHeader header;
+    if (size < kRawHeaderSize || !ParseHeader(data, header)) {
+        return false;
+    }
+
+    const i32 rows = RowCount(header);
+    out.assign(kHeaderSize + (size_t)rows * 4, 0);
+    std::memcpy(out.data(), kMagic, sizeof(kMagic));
+    WriteU32(out.data() + 4, kVersion);
+    WriteU32(out.data() + 8, Slope::kFracBits);
+    WriteU32(out.data() + 12, (u32)size);
+    std::memcpy(out.data() + 16, data, kRawHeaderSize);
+    WriteU32(out.data() + 23, (u32)rows);
+
+    const u8 *pos = data + kRawHeaderSize;
+    const u8 *end = data + size;
+    std::array<u8, 192 * 3> predicted;
+    for (i32 row = 0; row < rows; row++) {
+        const size_t rowStart = out.size();
+        bool valid = ForEachRecordInRow(header, row, [&](i32 slopeX, i32 slopeY, bool hasCoordinates) {
+            if (hasCoordinates) {
+                if (end - pos < 2 || pos[0] != (u8)slopeX || pos[1] != (u8)slopeY) {
+                    return false;
+                }
+                pos += 2;
+            }
+
+            const auto [firstLine, count] = RecordLines(header, slopeY);
+            if ((size_t)(end - pos) < (size_t)count * 3) {
+                return false;
+            }
+            Predict(header, slopeX, slopeY, firstLine, count, predicted.data());
+            EncodeSpans(pos, predicted.data(), count, out);
+            pos += count * 3;
+            return true;
+        });
+        if (!valid) {
+            return false;
+        }
+        WriteU32(out.data() + kHeaderSize + row * 4, (u32)(out.size() - rowStart));
+    }
+
+    out.insert(out.end(), pos, end);
+    return true;
+}
+
+bool CaptureCodec::Decompress(const u8 *data, size_t size, std::vector<u8> &out) {
+    Layout layout;
+    if (!LocateRows(data, size, layout)) {
+        return false;
+    }
+
+    out.resize(layout.rawSize);
+    std::memcpy(out.data(), data + 16, kRawHeaderSize);
+    std::memcpy(out.data() + layout.rawEnd, data + layout.end, size - layout.end);
+
+    // Rows are independent, so they are decoded in parallel
+    std::vector<u8> rowValid(layout.rows, false);
+    ParallelFor(layout.rows, [&](size_t row) {
+        rowValid[row] = DecodeRow(data, layout, (i32)row, out.data() + layout.rawOffsets[row]);
+    });
+    return std::all_of(rowValid.begin(), rowValid.end(), [](u8 valid) { return valid != 0; });
+}
+
+bool CaptureCodec::DecompressRows(const u8 *data, size_t size,
+                                  const std::function<bool(const u8 *, size_t)> &fn) {
+    Layout layout;
+    if (!LocateRows(data, size, layout)) {
+        return false;
+    }
+
+    if (!fn(data + 16, kRawHeaderSize)) {
+        return false;
+    }
+    std::vector<u8> raw;
+    for (i32 row = 0; row < layout.rows; row++) {
+        const size_t rawEnd = (row + 1 < layout.rows) ? layout.rawOffsets[row + 1] : layout.rawEnd;
+        raw.resize(rawEnd - layout.rawOffsets[row]);
+        if (!DecodeRow(data, layout, row, raw.data()) || !fn(raw.data(), raw.size())) {
+            return false;
+        }
+    }
+    return size == layout.end || fn(data + layout.end, size - layout.end);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/// <summary>
+/// Compresses and decompresses slope capture files by storing only the spans that differ from Slope's prediction.
+/// </summary>
+/// <remarks>
+/// A raw capture file consists of a 7-byte header followed by one record per slope, each storing 3 bytes (exists,
+/// start, end) for every scanline in the bounding box of the slope. Nearly all of those bytes can be computed from the
+/// slope itself: existing spans match Slope clipped to the bounding box, and scanlines where the slope has no span
+/// hold the bounds of the box. The compressed file stores every record as a list of exceptions against that
+/// prediction, which is computed again when decoding, so the format is lossless for any well-formed capture.
+///
+/// Each record is encoded as a series of tokens. A token starts with the number of scanlines that match the
+/// prediction, up to 255. If the record has more scanlines left, the token continues with a flags byte indicating which
+/// bytes of the next scanline differ from the prediction (bit 0 for exists, bit 1 for start and bit 2 for end),
+/// followed by the value of each differing byte. The record ends once all of its scanlines are covered.
+///
+/// The records are grouped into rows, one per row of slopes written by the generator, with the last row also holding
+/// the final record. The file stores the encoded size of every row, so the rows can be decoded in parallel.
+///
+/// The file consists of a header followed by the encoded records and any bytes that followed the records in the raw
+/// file:
+///
+///    Offset  Size  Contents
+///    0       4     Magic "NDSC"
+///    4       4     Format version (kVersion)
+///    8       4     Number of fractional bits of the interpolator (Slope::kFracBits)
+///    12      4     Size of the raw file
+///    16      7     Header of the raw file
+///    23      4     Number of rows R
+///    27      4*R   Encoded size of each row
+///    ...     ...   Encoded records
+///    ...     ...   Trailing bytes of the raw file
+///
+/// All values are little-endian. Decoding requires the same interpolator that encoded the file, so files are rejected
+/// if the number of fractional bits differs.
+/// </remarks>
+class CaptureCodec {
+    using u8 = uint8_t;
+    using u32 = uint32_t;
+    using i32 = int32_t;
+
+public:
+    /// <summary>
+    /// The current version of the file format.
+    /// </summary>
+    static constexpr u32 kVersion = 1;
+
+    /// <summary>
+    /// The size of the fixed part of the file header in bytes, up to the size of each row.
+    /// </summary>
+    static constexpr size_t kHeaderSize = 27;
+
+    /// <summary>
+    /// Determines if the specified file contents are a compressed capture.
+    /// </summary>
+    /// <param name="data">The contents of the file</param>
+    /// <param name="size">The size of the file in bytes</param>
+    /// <returns>true if the contents start with the magic of the compressed format.</returns>
+    static bool IsCompressed(const u8 *data, size_t size);
+
+    /// <summary>
+    /// Compresses a raw capture file.
+    /// </summary>
+    /// <param name="data">The contents of the raw file</param>
+    /// <param name="size">The size of the raw file in bytes</param>
+    /// <param name="out">Receives the contents of the compressed file</param>
+    /// <returns>true if the file was compressed, false if it is not a well-formed capture</returns>
+    static bool Compress(const u8 *data, size_t size, std::vector<u8> &out);
+
+    /// <summary>
+    /// Decompresses a compressed capture file, restoring the raw file byte for byte.
+    /// </summary>
+    /// <param name="data">The contents of the compressed file</param>
+    /// <param name="size">The size of the compressed file in bytes</param>
+    /// <param name="out">Receives the contents of the raw file</param>
+    /// <returns>true if the file was decompressed, false if it is malformed or uses an unsupported version</returns>
+    static bool Decompress(const u8 *data, size_t size, std::vector<u8> &out);
+
+    /// <summary>
+    /// Decompresses a compressed capture file one row of records at a time, so that the raw file can be processed in
+    /// order without holding all of it in memory.
+    /// </summary>
+    /// <remarks>
+    /// fn(bytes, count) receives consecutive pieces of the raw file: its header, then every row of records, then any
+    /// trailing bytes. The bytes are only valid during the call. Decoding stops if fn returns false.
+    /// </remarks>
+    /// <param name="data">The contents of the compressed file</param>
+    /// <param name="size">The size of the compressed file in bytes</param>
+    /// <param name="fn">The function that receives each piece of the raw file</param>
+    /// <returns>true if the whole file was decompressed and accepted by fn, false if it is malformed, uses an
+    /// unsupported version or fn returned false</returns>
+    static bool DecompressRows(const u8 *data, size_t size, const std::function<bool(const u8 *, size_t)> &fn);
+};
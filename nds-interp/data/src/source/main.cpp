@@ -29,6 +29,10 @@ constexpr bool screencap = false;
 // Set to true to generate test data, or false to test/validate
 constexpr bool generateData = true;
 
+// Set to true to generate test data in fast capture mode, which buffers the file in RAM and scans each frame while the
+// next one is being rendered. Produces the same file as the regular mode.
+constexpr bool fastCapture = false;
+
 // -------------------------------------------------------------------------------------------
 
 template <typename T>
@@ -60,6 +64,7 @@ const char* cullStrs[3] = { "Front", "Back", "None" };
 
 void test(PrintConsole* pc);
 void generate(PrintConsole* pc);
+void generateFast(PrintConsole* pc);
 void draw(u8 r, u8 g, u8 b);
 
 int main() {
@@ -102,7 +107,11 @@ int main() {
                     | DCAP_BANK(DCAP_BANK_VRAM_A);
 
     if (generateData) {
-        generate(pc);
+        if (fastCapture) {
+            generateFast(pc);
+        } else {
+            generate(pc);
+        }
     } else {
         test(pc);
     }
@@ -237,17 +246,19 @@ void test(PrintConsole* pc) {
     while(1);
 }
 
-void generate(PrintConsole* pc) {
-    fatInitDefault();
-    const char *filename;
+const char* dataFilename() {
     switch (TEST_TYPE) {
-        case TEST_TOP_LEFT: filename = "TL.bin"; break;
-        case TEST_TOP_RIGHT: filename = "TR.bin"; break;
-        case TEST_BOTTOM_LEFT: filename = "BL.bin"; break;
-        case TEST_BOTTOM_RIGHT: filename = "BR.bin"; break;
-        default: filename = "UNK.bin"; break;
+        case TEST_TOP_LEFT: return "TL.bin";
+        case TEST_TOP_RIGHT: return "TR.bin";
+        case TEST_BOTTOM_LEFT: return "BL.bin";
+        case TEST_BOTTOM_RIGHT: return "BR.bin";
+        default: return "UNK.bin";
     }
-    FILE* file = fopen(filename, "wb");
+}
+
+void generate(PrintConsole* pc) {
+    fatInitDefault();
+    FILE* file = fopen(dataFilename(), "wb");
     char testType = TEST_TYPE;
     fwrite(&testType, 1, sizeof(testType), file);
 
@@ -345,6 +356,145 @@ void generate(PrintConsole* pc) {
     }
 }
 
+// Size of the RAM buffer that holds the data file in fast capture mode before it is written out in large blocks
+constexpr int FAST_BUFFER_SIZE = 64 * 1024;
+u8 fastBuffer[FAST_BUFFER_SIZE];
+
+// Generates the same data file as generate(), but faster:
+// - The file is assembled in RAM and written out in large blocks instead of three 1-byte writes per span.
+// - Frames are captured into VRAM banks A and B alternately, and each capture is scanned while the next frame is being
+//   rendered and captured into the other bank, so the scan no longer costs a frame of its own.
+// - The console is only updated once per row of slopes.
+// As in generate(), the capture taken while a triangle is submitted shows the triangle submitted on the previous frame,
+// which is why every record is labelled with the previous coordinates and the first record holds a blank frame.
+void generateFast(PrintConsole* pc) {
+    fatInitDefault();
+    FILE* file = fopen(dataFilename(), "wb");
+
+    int bufferPos = 0;
+    auto flush = [&]() {
+        fwrite(fastBuffer, 1, bufferPos, file);
+        bufferPos = 0;
+    };
+    auto reserve = [&](int size) {
+        if (bufferPos + size > FAST_BUFFER_SIZE) flush();
+        u8* out = &fastBuffer[bufferPos];
+        bufferPos += size;
+        return out;
+    };
+
+    u8* header = reserve(7);
+    header[0] = TEST_TYPE;
+    header[1] = minX & 0xFF; header[2] = minX >> 8;
+    header[3] = maxX & 0xFF; header[4] = maxX >> 8;
+    header[5] = minY;
+    header[6] = maxY;
+
+    vramSetBankB(VRAM_B_LCD);
+    u16* const banks[2] = { VRAM_A, VRAM_B };
+    const u32 bankBits[2] = { DCAP_BANK(DCAP_BANK_VRAM_A), DCAP_BANK(DCAP_BANK_VRAM_B) };
+
+    // Scans the capture of a slope, writing its record with or without coordinates
+    auto scanAndWrite = [&](const u16* vram, int slopeX, int slopeY, bool writeCoords) {
+        if (writeCoords) {
+            u8* coords = reserve(2);
+            coords[0] = slopeX;
+            coords[1] = slopeY;
+        }
+
+        int startX = (TEST_TYPE & 1) ? min(slopeX, WIDTH - 1) : 0;
+        int endX = (TEST_TYPE & 1) ? (WIDTH - 1) : min(slopeX, WIDTH - 1);
+        int startY = (TEST_TYPE & 2) ? min(slopeY, HEIGHT - 1) : 0;
+        int endY = (TEST_TYPE & 2) ? (HEIGHT - 1) : min(slopeY, HEIGHT - 1);
+        for(int checkY = startY; checkY <= endY; checkY++) {
+            const u16* row = &vram[checkY * WIDTH];
+            int checkX = startX;
+            while (checkX <= endX && (row[checkX] & 0x7FFF) == 0) checkX++;
+            u8* span = reserve(3);
+            if (checkX > endX) {
+                span[0] = false;
+                span[1] = startX;
+                span[2] = endX;
+            } else {
+                span[0] = true;
+                span[1] = checkX;
+                while (checkX <= endX && (row[checkX] & 0x7FFF) != 0) checkX++;
+                span[2] = checkX - 1;
+            }
+        }
+    };
+
+    // Starts capturing the next frame into the specified bank and submits the triangle for the frame after it
+    auto startFrame = [&](int bank, int x, int y) {
+        swiWaitForVBlank();
+        while(REG_DISPCAPCNT & DCAP_ENABLE);
+        REG_DISPCAPCNT = (REG_DISPCAPCNT & ~DCAP_BANK(3)) | bankBits[bank] | DCAP_ENABLE;
+
+        verts[2][0] = originalVerts[2][0] + (x * X_DIFF);
+        verts[2][1] = originalVerts[2][1] - (y * Y_DIFF);
+        glPolyFmt(POLY_ALPHA(0) | POLY_CULL_NONE);
+        draw(255, 255, 255);
+        glFlush(0);
+    };
+
+    glDisable(GL_ANTIALIAS);
+    glEnable(GL_BLEND);
+
+    // Frame i captures the triangle submitted on frame i-1 into bank i%2, while the CPU scans the capture of frame i-1
+    // from the other bank
+    int frame = 0;
+    int capturedX = 0, capturedY = 0; // Triangle shown in the capture of the previous frame
+    int prevX = 0, prevY = 0;
+    for(int y = minY; y <= maxY; y++) {
+        pc->cursorX = 0;
+        pc->cursorY = 0;
+        consoleClear();
+        printf("%i\n", y);
+
+        for(int x = minX; x <= maxX; x++) {
+            startFrame(frame & 1, x, y);
+            if (frame > 0) {
+                scanAndWrite(banks[(frame - 1) & 1], capturedX, capturedY, true);
+            }
+            capturedX = prevX;
+            capturedY = prevY;
+            prevX = x;
+            prevY = y;
+            frame++;
+        }
+    }
+
+    // Capture the last triangle, then scan the remaining captures; the final record has no coordinates
+    startFrame(frame & 1, maxX, maxY);
+    if (frame > 0) {
+        scanAndWrite(banks[(frame - 1) & 1], capturedX, capturedY, true);
+    }
+    capturedX = prevX;
+    capturedY = prevY;
+    frame++;
+
+    swiWaitForVBlank();
+    while(REG_DISPCAPCNT & DCAP_ENABLE);
+    scanAndWrite(banks[(frame - 1) & 1], capturedX, capturedY, false);
+
+    if (screencap) {
+        FILE* fileFS = fopen("linetest-screencap.bin", "wb");
+        fseek(fileFS, 0, SEEK_SET);
+        fwrite(banks[(frame - 1) & 1], 256*192, sizeof(uint16_t), fileFS);
+        fclose(fileFS);
+    }
+
+    flush();
+    fclose(file);
+
+    while(1) {
+        pc->cursorX = 0;
+        pc->cursorY = 0;
+        printf("Done\n");
+        swiWaitForVBlank();
+    }
+}
+
 void draw(u8 r, u8 g, u8 b) {
     glBegin(GL_TRIANGLE);
         glColor3b(r, g, b);
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/// <summary>
+/// A bump allocator for the spans produced during one frame, reset once per frame.
+/// </summary>
+/// <remarks>
+/// The arena allocates a single block of memory up front and hands out consecutive pieces of it, so the spans of a
+/// frame are stored contiguously in the order they were produced and no memory is allocated while rendering. Reset
+/// releases every allocation at once at the end of the frame; individual allocations are never freed.
+///
+/// The Nintendo DS renders at most 2048 polygons per frame, which bounds the memory needed by a frame. The default
+/// capacity covers the worst case in which every polygon spans the full height of the screen, with room for both the
+/// Rasterizer spans of each scanline and the spans of the two edges on either side of it.
+///
+/// Allocate may be called from multiple threads at once, e.g. by the workers of ParallelFor. Reset must not run
+/// concurrently with any allocation. Only trivial types can be allocated since no constructor or destructor is run.
+/// </remarks>
+class FrameArena {
+public:
+    /// <summary>
+    /// The maximum number of polygons rendered by the Nintendo DS in a frame.
+    /// </summary>
+    static constexpr size_t kMaxPolygons = 2048;
+
+    /// <summary>
+    /// The number of bytes reserved for each scanline of a polygon: a 20-byte Rasterizer::Span plus the start and end
+    /// coordinates of two edges, rounded up to leave room for alignment.
+    /// </summary>
+    static constexpr size_t kBytesPerScanline = 40;
+
+    /// <summary>
+    /// The default capacity of the arena in bytes, enough for kMaxPolygons polygons covering all 192 scanlines.
+    /// </summary>
+    static constexpr size_t kDefaultCapacity = kMaxPolygons * 192 * kBytesPerScanline;
+
+    /// <summary>
+    /// The alignment of every allocation, which is sufficient for any fundamental type.
+    /// </summary>
+    static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+    /// <summary>
+    /// Creates an arena with the specified capacity, allocating all of its memory.
+    /// </summary>
+    /// <param name="capacity">The capacity in bytes</param>
+    explicit FrameArena(size_t capacity = kDefaultCapacity)
+        : m_memory(new unsigned char[capacity])
+        , m_capacity(capacity) {}
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /// <summary>
+    /// Allocates uninitialized storage for an array of objects, valid until the next call to Reset.
+    /// </summary>
+    /// <remarks>
+    /// Once an allocation fails, every following allocation fails as well until the arena is reset, so a frame that
+    /// runs out of memory can be detected by checking the last allocation or Exhausted.
+    /// </remarks>
+    /// <typeparam name="T">The type of the objects</typeparam>
+    /// <param name="count">The number of objects</param>
+    /// <returns>A pointer to the first object, or nullptr if the arena does not have enough space left</returns>
+    template <typename T>
+    T *Allocate(size_t count) {
+        static_assert(std::is_trivial_v<T>, "Only trivial types can be allocated from a frame arena");
+        static_assert(alignof(T) <= kAlignment, "Overaligned types cannot be allocated from a frame arena");
+        if (count > m_capacity / sizeof(T)) {
+            m_used.store(m_capacity + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        const size_t size = (count * sizeof(T) + kAlignment - 1) & ~(kAlignment - 1);
+        const size_t offset = m_used.fetch_add(size, std::memory_order_relaxed);
+        if (offset > m_capacity || size > m_capacity - offset) {
+            return nullptr;
+        }
+        return reinterpret_cast<T *>(m_memory.get() + offset);
+    }
+
+    /// <summary>
+    /// Releases every allocation, making the whole capacity available to the next frame.
+    /// </summary>
+    void Reset() {
+        m_peak = std::max(m_peak, Used());
+        m_used.store(0, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Retrieves the number of bytes allocated since the last call to Reset, including alignment padding.
+    /// </summary>
+    /// <returns>The number of bytes in use, at most Capacity()</returns>
+    size_t Used() const { return std::min(m_used.load(std::memory_order_relaxed), m_capacity); }
+
+    /// <summary>
+    /// Retrieves the largest number of bytes used by a frame, which helps choosing a capacity for a given workload.
+    /// </summary>
+    /// <returns>The largest value of Used() seen by Reset</returns>
+    size_t Peak() const { return std::max(m_peak, Used()); }
+
+    /// <summary>
+    /// Determines if an allocation failed since the last call to Reset.
+    /// </summary>
+    /// <returns>true if the arena ran out of space during the current frame</returns>
+    bool Exhausted() const { return m_used.load(std::memory_order_relaxed) > m_capacity; }
+
+    /// <summary>
+    /// Retrieves the capacity of the arena.
+    /// </summary>
+    /// <returns>The capacity in bytes</returns>
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    std::unique_ptr<unsigned char[]> m_memory; // The memory handed out by the arena
+    size_t m_capacity;                         // Size of the memory in bytes
+    std::atomic<size_t> m_used{0};             // Bytes allocated in the current frame, past the capacity if exhausted
+    size_t m_peak = 0;                         // Largest number of bytes used by a frame
+};
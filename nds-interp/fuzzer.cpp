@@ -0,0 +1,866 @@
+#include "fuzzer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "attribute_rasterizer.h"
+#include "parallel.h"
+#include "rasterizer.h"
+#include "slope.h"
+#include "slope_batch.h"
+#include "slope_kernel.h"
+#include "slope_simd.h"
+#include "span_cache.h"
+#include "span_lut.h"
+
+using u32 = uint32_t;
+using u64 = uint64_t;
+using i32 = int32_t;
+using i64 = int64_t;
+
+namespace {
+
+// Domain of the exhaustive run
+constexpr i32 kExhaustiveMinX = -128;
+constexpr i32 kExhaustiveWidth = 512;
+constexpr i32 kExhaustiveMinY = -32;
+constexpr i32 kExhaustiveHeight = 256;
+constexpr u64 kExhaustiveEndpoints = (u64)kExhaustiveWidth * kExhaustiveHeight;
+static_assert(kExhaustiveEndpoints * kExhaustiveEndpoints == kFuzzExhaustiveEdges);
+
+// Largest coordinate of random edges, which keeps every intermediate value of the interpolation within 32 bits
+constexpr i32 kRandomRange = 2047;
+
+// Maximum number of scanlines of an edge
+constexpr i32 kMaxLines = std::max(kExhaustiveHeight, 2 * kRandomRange + 1);
+
+// Number of edges in each work item
+constexpr u64 kBlockSize = 1 << 16;
+
+// Number of edges set up at once by SlopeBatch
+constexpr size_t kBatchSize = 256;
+
+// Number of entries of the span cache of each worker, small enough for edges to be evicted regularly
+constexpr size_t kCacheCapacity = 256;
+
+// Number of attributes interpolated by the attribute backends
+constexpr size_t kAttributeCount = 3;
+
+// Maximum number of mismatches described in detail for each backend
+constexpr size_t kMaxReports = 3;
+
+// Interval between progress reports
+constexpr std::chrono::seconds kProgressInterval{10};
+
+struct Edge {
+    i32 x0, y0, x1, y1;
+};
+
+// The paths that produce spans, each checked against the reference
+enum Backend {
+    kRandomAccess,        // Slope::FracXStart, FracXEnd and Coverage
+    kStepper,             // Slope::Stepper
+    kOriented,            // Slope::Oriented and its Stepper
+    kGenerateSpans,       // Slope::GenerateSpans, with and without coverage
+    kGenerateRuns,        // Slope::GenerateRuns
+    kBatch,               // SlopeBatch::Setup
+    kSSE41,               // GenerateSpansSIMD with SIMDKernel::SSE41
+    kAVX2,                // GenerateSpansSIMD with SIMDKernel::AVX2
+    kNEON,                // GenerateSpansSIMD with SIMDKernel::NEON
+    kKernel,              // SlopeKernelSetup and SlopeKernelSpanAt, shared with the compute shader
+    kLUT,                 // SpanLUT::Edge
+    kSpanCache,           // SpanCache::Get, on misses and hits
+    kBands,               // RasterizeBands, against Rasterizer::Rasterize on triangles formed by consecutive edges
+    kAttributes,          // AttributeInterpolator, along the Y or X coordinates of each edge
+    kAttributeRasterizer, // AttributeRasterizer, on the triangles of kBands
+    kBackendCount,
+};
+
+const char *backendName(int backend) {
+    switch (backend) {
+    case kRandomAccess: return "Slope random access";
+    case kStepper: return "Slope::Stepper";
+    case kOriented: return "Slope::Oriented";
+    case kGenerateSpans: return "Slope::GenerateSpans";
+    case kGenerateRuns: return "Slope::GenerateRuns";
+    case kBatch: return "SlopeBatch";
+    case kSSE41: return "GenerateSpansSIMD SSE4.1";
+    case kAVX2: return "GenerateSpansSIMD AVX2";
+    case kNEON: return "GenerateSpansSIMD NEON";
+    case kKernel: return "Compute shader kernel";
+    case kLUT: return "SpanLUT";
+    case kSpanCache: return "SpanCache";
+    case kBands: return "RasterizeBands";
+    case kAttributes: return "AttributeInterpolator";
+    case kAttributeRasterizer: return "AttributeRasterizer";
+    default: return "?";
+    }
+}
+
+// SIMD kernels and their backends
+constexpr std::array<std::pair<SIMDKernel, int>, 3> kKernels = {{
+    {SIMDKernel::SSE41, kSSE41},
+    {SIMDKernel::AVX2, kAVX2},
+    {SIMDKernel::NEON, kNEON},
+}};
+
+// Determines if a backend can be checked on this machine
+bool isBackendAvailable(int backend, const SpanLUT *lut) {
+    for (auto [kernel, kernelBackend] : kKernels) {
+        if (backend == kernelBackend) {
+            return IsSIMDKernelSupported(kernel);
+        }
+    }
+    return backend != kLUT || lut != nullptr;
+}
+
+// The hardware formulae documented in BasicSlope, evaluated in 64-bit arithmetic. This deliberately shares no code
+// with Slope, so that it can serve as the reference for every backend.
+class Reference {
+public:
+    static constexpr i64 kOne = 1 << 18;
+    static constexpr i64 kBias = kOne / 2;
+    static constexpr i64 kMaskedBits = (1 << 9) - 1;
+
+    explicit Reference(const Edge &edge) {
+        i32 x0 = edge.x0;
+        i32 y0 = edge.y0;
+        i32 x1 = edge.x1;
+        i32 y1 = edge.y1;
+        if (y1 < y0) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+
+        negative = (x1 < x0);
+        const i64 dx = negative ? (x0 - x1) : (x1 - x0);
+        const i64 dy = y1 - y0;
+        xMajor = (dx > dy);
+
+        top = y0;
+        bottom = (y1 == y0) ? (y0 + 1) : y1;
+        x0Frac = (i64)x0 * kOne;
+        if (negative) {
+            x0Frac -= 1;
+        }
+        if (xMajor || dx == dy) {
+            x0Frac += negative ? -kBias : kBias;
+        }
+        dxFrac = dx * (kOne / std::max<i64>(dy, 1));
+    }
+
+    i64 FracXStart(i32 y) const {
+        const i64 displacement = (y - top) * dxFrac;
+        return negative ? (x0Frac - displacement) : (x0Frac + displacement);
+    }
+
+    i64 FracXEnd(i32 y) const {
+        const i64 start = FracXStart(y);
+        if (!xMajor) {
+            return start;
+        }
+        if (negative) {
+            return start + (kMaskedBits - (start & kMaskedBits)) - dxFrac + kOne;
+        }
+        return (start & ~kMaskedBits) + dxFrac - kOne;
+    }
+
+    static i32 Screen(i64 frac) { return (i32)(frac >> 18); }
+
+    u32 Coverage(i32 y) const {
+        i64 frac = FracXStart(y) & (kOne - 1);
+        if (negative) {
+            frac = (kOne - 1) - frac;
+        }
+        return (u32)(frac >> (18 - 5));
+    }
+
+    Slope::Run Run(i32 y) const {
+        const i32 start = Screen(FracXStart(y));
+        const i32 end = Screen(FracXEnd(y));
+        const i32 prevEnd = Screen(FracXEnd(y - 1));
+        const bool hasPrev = xMajor && y > top;
+        if (negative) {
+            return {end, start - end + 1, hasPrev && (prevEnd - start > 1)};
+        }
+        return {start, end - start + 1, hasPrev && (start - prevEnd > 1)};
+    }
+
+    i32 top, bottom; // Scanlines covered by the edge (top inclusive, bottom exclusive)
+    i64 x0Frac;      // X0 coordinate (adjusted for bias and negative slopes)
+    i64 dxFrac;      // X displacement per scanline
+    bool negative;
+    bool xMajor;
+};
+
+using Attributes = AttributeInterpolator<kAttributeCount>::Values;
+
+// The linear interpolation documented in AttributeInterpolator, evaluated in 64-bit arithmetic: the reciprocal of the
+// coordinate delta, multiplied by the attribute delta, gives the step per unit of the coordinate.
+class AttributeReference {
+public:
+    AttributeReference(i32 c0, i32 c1, const Attributes &a0, const Attributes &a1) {
+        const bool swapped = (c1 < c0);
+        const Attributes &start = swapped ? a1 : a0;
+        const Attributes &end = swapped ? a0 : a1;
+        m_c0 = std::min(c0, c1);
+        const i64 reciprocal = Reference::kOne / std::max<i64>(std::abs((i64)c1 - c0), 1);
+        for (size_t i = 0; i < kAttributeCount; i++) {
+            m_start[i] = (i64)start[i] * Reference::kOne;
+            m_step[i] = ((i64)end[i] - start[i]) * reciprocal;
+        }
+    }
+
+    Attributes At(i32 c) const {
+        Attributes values{};
+        for (size_t i = 0; i < kAttributeCount; i++) {
+            values[i] = (i32)((m_start[i] + ((i64)c - m_c0) * m_step[i]) >> 18);
+        }
+        return values;
+    }
+
+    // Steps through the attributes of consecutive coordinates from the lower one, adding the step instead of
+    // multiplying it
+    class Stepper {
+    public:
+        explicit Stepper(const AttributeReference &ref) : m_values(ref.m_start), m_step(ref.m_step) {}
+
+        void Next() {
+            for (size_t i = 0; i < kAttributeCount; i++) {
+                m_values[i] += m_step[i];
+            }
+        }
+
+        Attributes Values() const {
+            Attributes values{};
+            for (size_t i = 0; i < kAttributeCount; i++) {
+                values[i] = (i32)(m_values[i] >> 18);
+            }
+            return values;
+        }
+
+    private:
+        std::array<i64, kAttributeCount> m_values;
+        std::array<i64, kAttributeCount> m_step;
+    };
+
+    Stepper Start() const { return Stepper{*this}; }
+
+private:
+    std::array<i64, kAttributeCount> m_start; // Attributes at the lower coordinate, with 18 fractional bits
+    std::array<i64, kAttributeCount> m_step;  // Attribute increments per unit of the coordinate
+    i32 m_c0;                                 // Lower coordinate
+};
+
+// Attributes of a vertex for the attribute backends: its X coordinate, which decreases along negative slopes, a mix of
+// both coordinates, and a 24-bit depth scrambled from them, whose deltas span the whole range of depth values
+Attributes vertexAttributes(i32 x, i32 y) {
+    const u32 hash = ((u32)x * 0x9E3779B1u) ^ ((u32)y * 0x85EBCA77u);
+    return {x, y - 3 * x, (i32)(hash >> 8)};
+}
+
+// Mismatches found by all workers
+struct Results {
+    std::array<std::atomic<u64>, kBackendCount> mismatches{};    // Number of mismatches per backend
+    std::mutex mutex;                                            // Protects the members below
+    std::array<std::vector<std::string>, kBackendCount> reports; // Descriptions of the first mismatches per backend
+};
+
+// Buffers of a worker
+struct Scratch {
+    std::vector<i64> refStarts = std::vector<i64>(kMaxLines);
+    std::vector<i64> refEnds = std::vector<i64>(kMaxLines);
+    std::vector<u32> refCoverage = std::vector<u32>(kMaxLines);
+    std::vector<i32> starts = std::vector<i32>(kMaxLines);
+    std::vector<i32> ends = std::vector<i32>(kMaxLines);
+    std::vector<u32> coverage = std::vector<u32>(kMaxLines);
+    std::vector<Slope::Run> runs = std::vector<Slope::Run>(kMaxLines);
+    std::vector<Attributes> attributes = std::vector<Attributes>(kMaxLines);
+    SpanCache cache{kCacheCapacity};
+};
+
+void report(Results &results, int backend, const Edge &edge, const std::string &detail) {
+    results.mismatches[backend]++;
+    std::lock_guard lock{results.mutex};
+    if (results.reports[backend].size() < kMaxReports) {
+        std::ostringstream out;
+        out << "(" << edge.x0 << "," << edge.y0 << ")-(" << edge.x1 << "," << edge.y1 << ") " << detail;
+        results.reports[backend].push_back(out.str());
+    }
+}
+
+std::string describeSpan(i32 y, i64 start, i64 end, i64 expectedStart, i64 expectedEnd) {
+    std::ostringstream out;
+    out << "Y=" << y << ": " << start << ".." << end << " != " << expectedStart << ".." << expectedEnd;
+    return out.str();
+}
+
+std::string describeAttributes(const Attributes &values) {
+    std::ostringstream out;
+    for (size_t i = 0; i < kAttributeCount; i++) {
+        out << (i > 0 ? "," : "") << values[i];
+    }
+    return out.str();
+}
+
+// Checks a backend that produces fixed-point spans through fn(y, start, end, coverage), stopping at the first
+// mismatching scanline
+template <typename Fn>
+void checkFrac(Results &results, int backend, const Edge &edge, const Reference &ref, const Scratch &scratch,
+               Fn &&fn) {
+    for (i32 y = ref.top; y < ref.bottom; y++) {
+        i64 start, end;
+        u32 coverage;
+        fn(y, start, end, coverage);
+        const i64 expectedStart = scratch.refStarts[y - ref.top];
+        const i64 expectedEnd = scratch.refEnds[y - ref.top];
+        if (start != expectedStart || end != expectedEnd || coverage != scratch.refCoverage[y - ref.top]) {
+            report(results, backend, edge, describeSpan(y, start, end, expectedStart, expectedEnd));
+            return;
+        }
+    }
+}
+
+// Checks screen coordinate spans generated into the scratch buffers
+void checkScreen(Results &results, int backend, const Edge &edge, const Reference &ref, const Scratch &scratch) {
+    for (i32 i = 0; i < ref.bottom - ref.top; i++) {
+        const i32 expectedStart = Reference::Screen(scratch.refStarts[i]);
+        const i32 expectedEnd = Reference::Screen(scratch.refEnds[i]);
+        if (scratch.starts[i] != expectedStart || scratch.ends[i] != expectedEnd) {
+            report(results, backend, edge,
+                   describeSpan(ref.top + i, scratch.starts[i], scratch.ends[i], expectedStart, expectedEnd));
+            return;
+        }
+    }
+}
+
+// Checks every backend of Slope on an edge
+void checkEdge(const Edge &edge, const Reference &ref, const SpanLUT *lut, Scratch &scratch, Results &results) {
+    const i32 top = ref.top;
+    const i32 bottom = ref.bottom;
+    const i32 lines = bottom - top;
+    for (i32 i = 0; i < lines; i++) {
+        scratch.refStarts[i] = ref.FracXStart(top + i);
+        scratch.refEnds[i] = ref.FracXEnd(top + i);
+        scratch.refCoverage[i] = ref.Coverage(top + i);
+    }
+
+    Slope slope;
+    slope.Setup(edge.x0, edge.y0, edge.x1, edge.y1);
+
+    checkFrac(results, kRandomAccess, edge, ref, scratch, [&](i32 y, i64 &start, i64 &end, u32 &coverage) {
+        start = slope.FracXStart(y);
+        end = slope.FracXEnd(y);
+        coverage = slope.Coverage(y);
+    });
+
+    Slope::Stepper stepper = slope.Begin(top);
+    checkFrac(results, kStepper, edge, ref, scratch, [&](i32, i64 &start, i64 &end, u32 &coverage) {
+        start = stepper.FracXStart();
+        end = stepper.FracXEnd();
+        coverage = stepper.Coverage();
+        stepper.Next();
+    });
+
+    slope.Dispatch([&](auto oriented) {
+        checkFrac(results, kOriented, edge, ref, scratch, [&](i32 y, i64 &start, i64 &end, u32 &coverage) {
+            start = oriented.FracXStart(y);
+            end = oriented.FracXEnd(y);
+            coverage = oriented.Coverage(y);
+        });
+
+        auto orientedStepper = oriented.Begin(top);
+        checkFrac(results, kOriented, edge, ref, scratch, [&](i32, i64 &start, i64 &end, u32 &coverage) {
+            start = orientedStepper.FracXStart();
+            end = orientedStepper.FracXEnd();
+            coverage = orientedStepper.Coverage();
+            orientedStepper.Next();
+        });
+    });
+
+    slope.GenerateSpans(top, bottom, scratch.starts.data(), scratch.ends.data());
+    checkScreen(results, kGenerateSpans, edge, ref, scratch);
+    slope.GenerateSpans(top, bottom, scratch.starts.data(), scratch.ends.data(), scratch.coverage.data());
+    checkScreen(results, kGenerateSpans, edge, ref, scratch);
+    for (i32 i = 0; i < lines; i++) {
+        if (scratch.coverage[i] != scratch.refCoverage[i]) {
+            report(results, kGenerateSpans, edge,
+                   "Y=" + std::to_string(top + i) + ": coverage " + std::to_string(scratch.coverage[i]) +
+                       " != " + std::to_string(scratch.refCoverage[i]));
+            break;
+        }
+    }
+
+    slope.GenerateRuns(top, bottom, scratch.runs.data());
+    for (i32 i = 0; i < lines; i++) {
+        const Slope::Run &run = scratch.runs[i];
+        const Slope::Run expected = ref.Run(top + i);
+        if (run.x != expected.x || run.length != expected.length || run.gap != expected.gap) {
+            std::ostringstream detail;
+            detail << "Y=" << top + i << ": run " << run.x << "+" << run.length << (run.gap ? " gap" : "") << " != "
+                   << expected.x << "+" << expected.length << (expected.gap ? " gap" : "");
+            report(results, kGenerateRuns, edge, detail.str());
+            break;
+        }
+    }
+
+    for (auto [kernel, backend] : kKernels) {
+        if (IsSIMDKernelSupported(kernel)) {
+            GenerateSpansSIMD(kernel, slope, top, bottom, scratch.starts.data(), scratch.ends.data());
+            checkScreen(results, backend, edge, ref, scratch);
+        }
+    }
+
+    const SlopeKernelParams kernel = SlopeKernelSetup(edge.x0, edge.y0, edge.x1, edge.y1);
+    for (i32 i = 0; i < lines; i++) {
+        const SlopeKernelSpan span = SlopeKernelSpanAt(kernel, top + i);
+        scratch.starts[i] = span.start;
+        scratch.ends[i] = span.end;
+    }
+    checkScreen(results, kKernel, edge, ref, scratch);
+
+    SpanLUT::Edge lutEdge;
+    if (lut != nullptr && lut->Setup(edge.x0, edge.y0, edge.x1, edge.y1, lutEdge)) {
+        if (lutEdge.Y0() != top || lutEdge.Lines() != lines) {
+            report(results, kLUT, edge,
+                   "covers " + std::to_string(lutEdge.Lines()) + " scanlines from Y=" + std::to_string(lutEdge.Y0()));
+        } else {
+            for (i32 i = 0; i < lines; i++) {
+                scratch.starts[i] = lutEdge.XStart(top + i);
+                scratch.ends[i] = lutEdge.XEnd(top + i);
+            }
+            checkScreen(results, kLUT, edge, ref, scratch);
+        }
+    }
+
+    // Each edge gets a frame of its own, so that only edges too tall for the cache can bypass it. The first lookup
+    // generates the spans unless the edge is still cached from a previous batch, and the second one, in the opposite
+    // direction, must find them. Horizontal edges are not reversed, as that changes their spans.
+    scratch.cache.NextFrame();
+    const int passes = (edge.y0 == edge.y1) ? 1 : 2;
+    for (int pass = 0; pass < passes; pass++) {
+        const Edge lookup = (pass == 0) ? edge : Edge{edge.x1, edge.y1, edge.x0, edge.y0};
+        const u64 hits = scratch.cache.GetStats().hits;
+        SpanCache::Edge cached;
+        if (!scratch.cache.Get(lookup.x0, lookup.y0, lookup.x1, lookup.y1, cached)) {
+            if (lines <= SpanCache::kMaxLines) {
+                report(results, kSpanCache, edge, "not cached");
+            }
+            break;
+        }
+        if (pass == 1 && scratch.cache.GetStats().hits == hits) {
+            report(results, kSpanCache, edge, "reversed edge not found");
+            break;
+        }
+        if (cached.y0 != top || cached.lines != lines || cached.negative != ref.negative) {
+            report(results, kSpanCache, edge,
+                   "covers " + std::to_string(cached.lines) + " scanlines from Y=" + std::to_string(cached.y0));
+            break;
+        }
+        std::copy_n(cached.starts, lines, scratch.starts.begin());
+        std::copy_n(cached.ends, lines, scratch.ends.begin());
+        checkScreen(results, kSpanCache, edge, ref, scratch);
+    }
+}
+
+// Checks AttributeInterpolator between the attributes of the endpoints of an edge at every coordinate between them,
+// along its Y coordinates if yAxis is true or along its X coordinates otherwise. Horizontal and vertical edges have
+// equal coordinates along one of them.
+void checkAttributes(const Edge &edge, bool yAxis, Scratch &scratch, Results &results) {
+    const Attributes a0 = vertexAttributes(edge.x0, edge.y0);
+    const Attributes a1 = vertexAttributes(edge.x1, edge.y1);
+    const i32 c0 = yAxis ? edge.y0 : edge.x0;
+    const i32 c1 = yAxis ? edge.y1 : edge.x1;
+    AttributeInterpolator<kAttributeCount> interpolator;
+    interpolator.Setup(c0, c1, a0, a1);
+    const AttributeReference ref{c0, c1, a0, a1};
+    const i32 first = std::min(c0, c1);
+    const i32 last = std::max(c0, c1);
+    interpolator.Generate(first, last + 1, scratch.attributes.data());
+
+    // The whole range is compared without branches, and the mismatch is only located if there is one. Evaluate(c)
+    // returns the output of Evaluate(c, out), so only the latter is compared.
+    bool match = true;
+    AttributeReference::Stepper stepper = ref.Start();
+    for (i32 c = first; c <= last; c++, stepper.Next()) {
+        const Attributes expected = stepper.Values();
+        Attributes evaluated;
+        interpolator.Evaluate(c, evaluated);
+        const Attributes &generated = scratch.attributes[c - first];
+        for (size_t i = 0; i < kAttributeCount; i++) {
+            match &= (evaluated[i] == expected[i]) & (generated[i] == expected[i]);
+        }
+    }
+    for (i32 c = first; !match && c <= last; c++) {
+        const Attributes expected = ref.At(c);
+        const Attributes evaluated = interpolator.Evaluate(c);
+        const Attributes &generated = scratch.attributes[c - first];
+        if (evaluated != expected || generated != expected) {
+            const bool evaluateFailed = evaluated != expected;
+            std::ostringstream detail;
+            detail << (evaluateFailed ? "Evaluate " : "Generate ") << (yAxis ? "Y=" : "X=") << c << ": "
+                   << describeAttributes(evaluateFailed ? evaluated : generated) << " != "
+                   << describeAttributes(expected);
+            report(results, kAttributes, edge, detail.str());
+            return;
+        }
+    }
+}
+
+// Checks the parameters computed by SlopeBatch for a set of edges
+void checkBatch(const Edge *edges, size_t count, SlopeBatch<kBatchSize> &batch, Results &results) {
+    std::array<i32, kBatchSize> x0{}, y0{}, x1{}, y1{};
+    for (size_t i = 0; i < count; i++) {
+        x0[i] = edges[i].x0;
+        y0[i] = edges[i].y0;
+        x1[i] = edges[i].x1;
+        y1[i] = edges[i].y1;
+    }
+    batch.Setup(x0.data(), y0.data(), x1.data(), y1.data(), count);
+    for (size_t i = 0; i < count; i++) {
+        const Reference ref{edges[i]};
+        if (batch.X0()[i] != ref.x0Frac || batch.Y0()[i] != ref.top || batch.Y1()[i] != ref.bottom ||
+            batch.DX()[i] != ref.dxFrac || (batch.Negative()[i] != 0) != ref.negative ||
+            (batch.XMajor()[i] != 0) != ref.xMajor) {
+            std::ostringstream detail;
+            detail << "X0=" << batch.X0()[i] << " DX=" << batch.DX()[i] << " != X0=" << ref.x0Frac
+                   << " DX=" << ref.dxFrac;
+            report(results, kBatch, edges[i], detail.str());
+        }
+    }
+}
+
+// Forms a triangle from an edge of a batch and the first endpoint of the next one. Every eighth triangle is flattened
+// to test polygons with no height.
+std::array<Rasterizer::Vertex, 3> triangleAt(const Edge *edges, size_t count, size_t i) {
+    const Edge &edge = edges[i];
+    const Edge &next = edges[(i + 1) % count];
+    const bool flat = i % 8 == 0;
+    return {{{edge.x0, edge.y0}, {edge.x1, flat ? edge.y0 : edge.y1}, {next.x0, flat ? edge.y0 : next.y0}}};
+}
+
+bool sameSpan(const Rasterizer::Span &a, const Rasterizer::Span &b) {
+    return a.y == b.y && a.xStart == b.xStart && a.xEnd == b.xEnd && a.leftEdgeEnd == b.leftEdgeEnd &&
+           a.rightEdgeStart == b.rightEdgeStart;
+}
+
+// Checks that RasterizeBands produces the same spans as rasterizing each polygon over the whole screen, on the
+// triangles formed by triangleAt
+void checkBands(WorkerPool &pool, const Edge *edges, size_t count, int32_t bandHeight, Results &results) {
+    std::array<Rasterizer, kBatchSize> polygons;
+    for (size_t i = 0; i < count; i++) {
+        polygons[i].Setup(triangleAt(edges, count, i).data(), 3);
+    }
+
+    std::mutex mutex;
+    std::array<std::vector<Rasterizer::Span>, kBatchSize> bandSpans;
+    std::array<bool, kBatchSize> emptyCall{};
+    RasterizeBands(
+        pool, polygons.data(), count,
+        [&](size_t polygon, const Rasterizer::Span *spans, size_t numSpans) {
+            std::lock_guard lock{mutex};
+            emptyCall[polygon] |= numSpans == 0;
+            bandSpans[polygon].insert(bandSpans[polygon].end(), spans, spans + numSpans);
+        },
+        bandHeight);
+
+    std::array<Rasterizer::Span, Rasterizer::kScreenHeight> expected;
+    for (size_t i = 0; i < count; i++) {
+        std::vector<Rasterizer::Span> &spans = bandSpans[i];
+        std::sort(spans.begin(), spans.end(), [](auto &a, auto &b) { return a.y < b.y; });
+        const size_t numExpected = polygons[i].Rasterize(expected.data(), expected.size());
+        bool match = !emptyCall[i] && spans.size() == numExpected;
+        for (size_t k = 0; match && k < numExpected; k++) {
+            match = sameSpan(spans[k], expected[k]);
+        }
+        if (!match) {
+            const Edge &next = edges[(i + 1) % count];
+            std::ostringstream detail;
+            detail << "+(" << next.x0 << "," << next.y0 << ")" << (i % 8 == 0 ? " flattened" : "") << " with bands of "
+                   << bandHeight << ": " << spans.size() << " spans != " << numExpected;
+            report(results, kBands, edges[i], detail.str());
+        }
+    }
+}
+
+// Checks AttributeRasterizer on the triangles formed by triangleAt. The spans must match those of Rasterizer, and the
+// attributes of each side of a span must match the reference interpolation along the edge on that side, which is the
+// edge covering the scanline that lies further to the left or right. Polygons with no height take the attributes of
+// their leftmost and rightmost vertices.
+void checkAttributeRasterizer(const Edge *edges, size_t count, Results &results) {
+    std::array<Rasterizer::Span, Rasterizer::kScreenHeight> spans, expected;
+    std::array<Attributes, Rasterizer::kScreenHeight> left, right;
+    for (size_t i = 0; i < count; i++) {
+        const std::array<Rasterizer::Vertex, 3> vertices = triangleAt(edges, count, i);
+        std::array<Attributes, 3> attributes;
+        for (size_t k = 0; k < 3; k++) {
+            attributes[k] = vertexAttributes(vertices[k].x, vertices[k].y);
+        }
+        AttributeRasterizer<kAttributeCount> rasterizer;
+        rasterizer.Setup(vertices.data(), attributes.data(), 3);
+        Rasterizer polygon;
+        polygon.Setup(vertices.data(), 3);
+
+        const Edge &next = edges[(i + 1) % count];
+        std::ostringstream detail;
+        detail << "+(" << next.x0 << "," << next.y0 << ")" << (i % 8 == 0 ? " flattened" : "") << ": ";
+        const size_t numSpans = rasterizer.Rasterize(spans.data(), left.data(), right.data(), spans.size());
+        const size_t numExpected = polygon.Rasterize(expected.data(), expected.size());
+        bool match = numSpans == numExpected;
+        for (size_t k = 0; match && k < numSpans; k++) {
+            match = sameSpan(spans[k], expected[k]);
+        }
+        if (!match) {
+            detail << numSpans << " spans != " << numExpected;
+            report(results, kAttributeRasterizer, edges[i], detail.str());
+            continue;
+        }
+
+        for (size_t k = 0; k < numSpans; k++) {
+            const i32 y = spans[k].y;
+            Attributes expectedLeft, expectedRight;
+            bool tied = false;
+            if (polygon.Top() == polygon.Bottom()) {
+                size_t leftVertex = 0;
+                size_t rightVertex = 0;
+                for (size_t v = 1; v < 3; v++) {
+                    leftVertex = (vertices[v].x < vertices[leftVertex].x) ? v : leftVertex;
+                    rightVertex = (vertices[v].x > vertices[rightVertex].x) ? v : rightVertex;
+                }
+                expectedLeft = attributes[leftVertex];
+                expectedRight = attributes[rightVertex];
+            } else {
+                // Exactly two edges with some height cover each scanline of a triangle
+                std::array<Attributes, 2> sides;
+                std::array<std::pair<i32, i32>, 2> extents;
+                size_t numSides = 0;
+                for (size_t v = 0; v < 3 && numSides < 2; v++) {
+                    const size_t n = (v + 1) % 3;
+                    const Reference ref{{vertices[v].x, vertices[v].y, vertices[n].x, vertices[n].y}};
+                    if (vertices[v].y == vertices[n].y || y < ref.top || y >= ref.bottom) {
+                        continue;
+                    }
+                    const i32 start = Reference::Screen(ref.FracXStart(y));
+                    const i32 end = Reference::Screen(ref.FracXEnd(y));
+                    extents[numSides] = ref.negative ? std::pair{end, start} : std::pair{start, end};
+                    const AttributeReference side{vertices[v].y, vertices[n].y, attributes[v], attributes[n]};
+                    sides[numSides] = side.At(y);
+                    numSides++;
+                }
+                const bool swapped = extents[0] > extents[1];
+                tied = extents[0] == extents[1];
+                expectedLeft = sides[swapped ? 1 : 0];
+                expectedRight = sides[swapped ? 0 : 1];
+            }
+
+            // Edges with the same extent on a scanline may be paired either way
+            const bool sidesMatch = left[k] == expectedLeft && right[k] == expectedRight;
+            if (!sidesMatch && !(tied && left[k] == expectedRight && right[k] == expectedLeft)) {
+                detail << "Y=" << y << ": " << describeAttributes(left[k]) << " | " << describeAttributes(right[k])
+                       << " != " << describeAttributes(expectedLeft) << " | " << describeAttributes(expectedRight);
+                report(results, kAttributeRasterizer, edges[i], detail.str());
+                break;
+            }
+        }
+    }
+}
+
+// Formats a duration as hours, minutes and seconds
+std::string describeDuration(u64 seconds) {
+    std::ostringstream out;
+    if (seconds >= 3600) {
+        out << seconds / 3600 << "h ";
+    }
+    if (seconds >= 60) {
+        out << (seconds / 60) % 60 << "m ";
+    }
+    out << seconds % 60 << "s";
+    return out.str();
+}
+
+// Checks count edges in parallel, obtaining each one with edgeAt(index), and prints the results
+template <typename EdgeFn>
+bool fuzz(u64 count, const SpanLUT *lut, EdgeFn &&edgeAt) {
+    using Clock = std::chrono::steady_clock;
+
+    std::cout << "Backends:";
+    for (int backend = 0; backend < kBackendCount; backend++) {
+        if (isBackendAvailable(backend, lut)) {
+            std::cout << " [" << backendName(backend) << "]";
+        }
+    }
+    std::cout << "\n";
+    const size_t numThreads = WorkerCount();
+    std::cout << "Using " << numThreads << " worker thread" << (numThreads == 1 ? "" : "s") << "\n";
+
+    Results results;
+    const auto start = Clock::now();
+    auto nextProgress = start + kProgressInterval;
+    std::atomic<u64> done{0};
+    const u64 numBlocks = (count + kBlockSize - 1) / kBlockSize;
+    WorkerPool bandPool;
+    ParallelFor(numBlocks, [&](size_t block) {
+        Scratch scratch;
+        SlopeBatch<kBatchSize> batch;
+        std::array<Edge, kBatchSize> edges;
+        const u64 first = block * kBlockSize;
+        const u64 last = std::min(first + kBlockSize, count);
+        for (u64 index = first; index < last; index += kBatchSize) {
+            const size_t numEdges = (size_t)std::min<u64>(kBatchSize, last - index);
+            for (size_t i = 0; i < numEdges; i++) {
+                edges[i] = edgeAt(index + i);
+                checkEdge(edges[i], Reference{edges[i]}, lut, scratch, results);
+                // The interpolator does not depend on the axis, so alternating them halves its cost
+                checkAttributes(edges[i], (index + i) % 2 == 0, scratch, results);
+            }
+            checkBatch(edges.data(), numEdges, batch, results);
+            checkAttributeRasterizer(edges.data(), numEdges, results);
+
+            // All blocks share the workers of RasterizeBands, so it is only checked on the first batch of each block,
+            // with a different band height on each block
+            if (index == first) {
+                checkBands(bandPool, edges.data(), numEdges, 1 + (int32_t)(block % Rasterizer::kScreenHeight),
+                           results);
+            }
+        }
+
+        const u64 total = done += last - first;
+        std::lock_guard lock{results.mutex};
+        const auto now = Clock::now();
+        if (now >= nextProgress) {
+            const double seconds = std::chrono::duration<double>(now - start).count();
+            const double rate = total / seconds;
+            std::cout << std::fixed << std::setprecision(2) << std::setw(7) << (100.0 * total / count) << "%  "
+                      << total << " edges, " << (rate / 1e6) << "M edges/s, "
+                      << describeDuration((u64)((count - total) / rate)) << " left\n";
+            nextProgress = now + kProgressInterval;
+        }
+    });
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "Checked " << count << " edges in " << std::fixed << std::setprecision(2) << seconds << " s ("
+              << (count / seconds / 1e6) << "M edges/s on " << numThreads << " thread" << (numThreads == 1 ? "" : "s")
+              << ")\n";
+    bool ok = true;
+    for (int backend = 0; backend < kBackendCount; backend++) {
+        if (results.mismatches[backend] != 0) {
+            std::cout << std::setw(28) << std::left << backendName(backend) << std::right
+                      << results.mismatches[backend] << " mismatches\n";
+            for (auto &line : results.reports[backend]) {
+                std::cout << "  " << line << "\n";
+            }
+            ok = false;
+        }
+    }
+    if (ok) {
+        std::cout << "All backends match the reference\n";
+    }
+    return ok;
+}
+
+// SplitMix64, a generator that is cheap enough to seed for every edge
+struct SplitMix {
+    using result_type = u64;
+
+    static constexpr u64 min() { return 0; }
+    static constexpr u64 max() { return ~0ull; }
+
+    u64 operator()() {
+        u64 z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    u64 state;
+};
+
+// Generates a random edge within the random domain. The generator is seeded for every edge, so the edges depend only
+// on the seed and their index, regardless of how they are split among the workers.
+Edge randomEdge(u64 seed, u64 index) {
+    SplitMix gen{seed ^ (index * 0xD1B54A32D192ED03ull)};
+    auto uniform = [&](i32 min, i32 max) { return std::uniform_int_distribution<i32>{min, max}(gen); };
+    auto clamp = [](i32 value) { return std::clamp(value, -kRandomRange, kRandomRange); };
+
+    Edge edge;
+    edge.x0 = uniform(-kRandomRange, kRandomRange);
+    edge.y0 = uniform(-kRandomRange, kRandomRange);
+    i32 dx, dy;
+    switch (gen() % 8) {
+    case 0:
+    case 1:
+    case 2:
+        // Around the screen, extending one screen in every direction
+        edge.x0 = uniform(-256, 511);
+        edge.y0 = uniform(-192, 383);
+        dx = uniform(-256, 511) - edge.x0;
+        dy = uniform(-192, 383) - edge.y0;
+        break;
+    case 3:
+        // Anywhere in the domain
+        dx = uniform(-kRandomRange, kRandomRange) - edge.x0;
+        dy = uniform(-kRandomRange, kRandomRange) - edge.y0;
+        break;
+    case 4:
+        // Short edges
+        dx = uniform(-16, 16);
+        dy = uniform(-16, 16);
+        break;
+    case 5:
+        // Horizontal, vertical and diagonal edges
+        dy = uniform(-512, 512);
+        switch (gen() % 4) {
+        case 0: dx = uniform(-2048, 2048); dy = 0; break;
+        case 1: dx = 0; break;
+        case 2: dx = dy; break;
+        default: dx = -dy; break;
+        }
+        break;
+    case 6:
+        // Deltas around the end of the reciprocal table
+        dx = uniform(-512, 512);
+        dy = uniform(248, 266) * ((gen() & 1) ? 1 : -1);
+        break;
+    default:
+        // Nearly horizontal edges with long spans
+        dx = uniform(-2 * kRandomRange, 2 * kRandomRange);
+        dy = uniform(-8, 8);
+        break;
+    }
+    edge.x1 = clamp(edge.x0 + dx);
+    edge.y1 = clamp(edge.y0 + dy);
+    return edge;
+}
+
+} // namespace
+
+bool fuzzExhaustive(u64 first, u64 count, const SpanLUT *lut) {
+    first = std::min(first, kFuzzExhaustiveEdges);
+    count = std::min(count, kFuzzExhaustiveEdges - first);
+    std::cout << "Fuzzing edges " << first << " to " << (first + count) << " of " << kFuzzExhaustiveEdges << "\n";
+    return fuzz(count, lut, [&](u64 index) {
+        const u64 p0 = (first + index) / kExhaustiveEndpoints;
+        const u64 p1 = (first + index) % kExhaustiveEndpoints;
+        return Edge{
+            kExhaustiveMinX + (i32)(p0 % kExhaustiveWidth),
+            kExhaustiveMinY + (i32)(p0 / kExhaustiveWidth),
+            kExhaustiveMinX + (i32)(p1 % kExhaustiveWidth),
+            kExhaustiveMinY + (i32)(p1 / kExhaustiveWidth),
+        };
+    });
+}
+
+bool fuzzRandom(u64 seed, u64 count, const SpanLUT *lut) {
+    std::cout << "Fuzzing " << count << " random edges with seed " << seed << "\n";
+    return fuzz(count, lut, [&](u64 index) { return randomEdge(seed, index); });
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+class SpanLUT;
+
+/// <summary>
+/// The number of edges checked by an exhaustive run: every ordered pair of endpoints with X coordinates from -128 to
+/// 383 and Y coordinates from -32 to 223, which covers the screen with half of its width and a sixth of its height to
+/// spare on each side.
+/// </summary>
+constexpr uint64_t kFuzzExhaustiveEdges = 1ull << 34;
+
+/// <summary>
+/// Exhaustively checks that every interpolation backend matches the reference on a range of edges.
+/// </summary>
+/// <remarks>
+/// Each edge is interpolated by a straightforward 64-bit implementation of the hardware formulae documented in
+/// BasicSlope, which serves as the reference, and by Slope's random access, Stepper, Oriented, GenerateSpans,
+/// GenerateRuns and coverage; the setup of SlopeBatch; every SIMD kernel supported by the CPU; the kernel of the
+/// compute shader; SpanCache, on both misses and hits; and the span lookup table, if one is provided. Attributes
+/// derived from the coordinates of the endpoints are interpolated by AttributeInterpolator along the Y or X coordinates
+/// of each edge, alternately, and compared with a 64-bit evaluation of the same linear formula. Each edge also forms a
+/// triangle with the next one, which AttributeRasterizer must rasterize into the spans of Rasterizer::Rasterize with
+/// the attributes of the edges on either side; the first batch of edges of every block of 65536 edges must also be
+/// rasterized identically by RasterizeBands, with band heights varying from block to block. GenerateSubSpans is not
+/// checked, as the reference has no counterpart for it.
+///
+/// The edges are numbered from 0 to kFuzzExhaustiveEdges - 1 and checked in blocks distributed by ParallelFor, so
+/// checking scales with the number of hardware threads. A single thread of an optimized build checks about 250000 of
+/// these edges per second, so a full run takes about 20 hours of CPU time and is meant to be split into ranges spread
+/// over multiple runs or machines. Progress, throughput in edges per second and the estimated time left are printed
+/// periodically, followed by a summary of the mismatches found in each backend.
+/// </remarks>
+/// <param name="first">The index of the first edge to check</param>
+/// <param name="count">The number of edges to check</param>
+/// <param name="lut">The span lookup table to check, or nullptr to skip it</param>
+/// <returns>true if every backend matched the reference on every edge</returns>
+bool fuzzExhaustive(uint64_t first, uint64_t count, const SpanLUT *lut);
+
+/// <summary>
+/// Checks that every interpolation backend matches the reference on random edges.
+/// </summary>
+/// <remarks>
+/// Runs the same checks as fuzzExhaustive on edges drawn from a wider domain with X and Y coordinates up to +/-2047,
+/// biased towards the cases that exercise special paths: horizontal, vertical and diagonal edges, edges with deltas
+/// just past the reciprocal table and short edges anywhere in the domain. The edges only depend on the seed, so any
+/// reported mismatch can be reproduced. The edges are much longer than those of fuzzExhaustive on average, so a single
+/// thread only checks about 100000 of them per second.
+/// </remarks>
+/// <param name="seed">The seed of the random number generator</param>
+/// <param name="count">The number of edges to check</param>
+/// <param name="lut">The span lookup table to check, or nullptr to skip it</param>
+/// <returns>true if every backend matched the reference on every edge</returns>
+bool fuzzRandom(uint64_t seed, uint64_t count, const SpanLUT *lut);
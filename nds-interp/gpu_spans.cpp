@@ -0,0 +1,36 @@
+#include "gpu_spans.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "parallel.h"
+
+static_assert(sizeof(SlopeKernelEdge) == 24, "SlopeKernelEdge must match the std430 layout of the shader");
+static_assert(sizeof(SlopeKernelSpan) == 8, "SlopeKernelSpan must match the std430 layout of the shader");
+
+void GPUSpanBatch::Clear() {
+    m_edges.clear();
+    m_spans.clear();
+}
+
+size_t GPUSpanBatch::Add(i32 x0, i32 y0, i32 x1, i32 y1) {
+    const size_t firstSpan = m_spans.size();
+    const i32 lines = std::max(std::abs(y1 - y0), 1);
+    m_edges.push_back({x0, y0, x1, y1, (i32)firstSpan, lines});
+    m_spans.resize(firstSpan + lines);
+    return firstSpan;
+}
+
+void GPUSpanBatch::Emulate() {
+    // Each work item runs the invocations of one workgroup, mirroring main() in shaders/slope_spans.comp
+    ParallelFor(WorkgroupCount(), [&](size_t group) {
+        const size_t end = std::min((group + 1) * kWorkgroupSize, m_edges.size());
+        for (size_t index = group * kWorkgroupSize; index < end; index++) {
+            const SlopeKernelEdge &edge = m_edges[index];
+            const SlopeKernelParams slope = SlopeKernelSetup(edge.x0, edge.y0, edge.x1, edge.y1);
+            for (i32 i = 0; i < edge.lines; i++) {
+                m_spans[edge.firstSpan + i] = SlopeKernelSpanAt(slope, slope.y0 + i);
+            }
+        }
+    });
+}
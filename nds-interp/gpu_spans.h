@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "slope_kernel.h"
+
+/// <summary>
+/// Packs a batch of edges into the buffers consumed and produced by the compute shader in shaders/slope_spans.comp.
+/// </summary>
+/// <remarks>
+/// The shader generates the spans of every edge of a frame in a single dispatch, one invocation per edge, with the
+/// interpolation in slope_kernel.h, which is compiled both into the shader and into this class. The spans are
+/// bit-identical to those of Slope::GenerateSpans.
+///
+/// Add the edges of a frame with Add, upload Edges to the storage buffer at binding 0, allocate SpanBufferSize bytes
+/// for the storage buffer at binding 1 and dispatch WorkgroupCount workgroups. The spans of each edge are laid out
+/// contiguously and in edge order, from the top scanline to the bottom, starting at the index returned by Add. The
+/// class does not depend on a graphics API; binding the buffers is left to the renderer.
+///
+/// Emulate runs the shader on the CPU and writes the span buffer that a dispatch would produce, which checks the
+/// kernel against the rest of the interpolators without a GPU and serves as a fallback when none is available.
+/// </remarks>
+class GPUSpanBatch {
+    using i32 = int32_t;
+
+public:
+    /// <summary>
+    /// The number of invocations per workgroup, matching local_size_x in the shader.
+    /// </summary>
+    static constexpr size_t kWorkgroupSize = 64;
+
+    /// <summary>
+    /// Removes every edge and span from the batch, keeping the allocated memory.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Adds the slope (X0,Y0)-(X1,Y1) to the batch.
+    /// </summary>
+    /// <remarks>
+    /// The edge covers the same scanlines as Slope: from the top endpoint up to, but excluding, the bottom endpoint, or
+    /// a single scanline for horizontal edges.
+    /// </remarks>
+    /// <param name="x0">First X coordinate</param>
+    /// <param name="y0">First Y coordinate</param>
+    /// <param name="x1">Second X coordinate</param>
+    /// <param name="y1">Second Y coordinate</param>
+    /// <returns>The index of the first span of the edge in the span buffer</returns>
+    size_t Add(i32 x0, i32 y0, i32 x1, i32 y1);
+
+    /// <summary>
+    /// Writes the span buffer on the CPU, exactly as a dispatch of the shader would.
+    /// </summary>
+    void Emulate();
+
+    /// <summary>
+    /// Retrieves the edge buffer, to be uploaded to the storage buffer at binding 0.
+    /// </summary>
+    /// <returns>A pointer to the first edge</returns>
+    const SlopeKernelEdge *Edges() const { return m_edges.data(); }
+
+    /// <summary>
+    /// Retrieves the number of edges in the batch.
+    /// </summary>
+    /// <returns>The number of edges</returns>
+    size_t EdgeCount() const { return m_edges.size(); }
+
+    /// <summary>
+    /// Retrieves the size of the edge buffer.
+    /// </summary>
+    /// <returns>The size of the edge buffer in bytes</returns>
+    size_t EdgeBufferSize() const { return m_edges.size() * sizeof(SlopeKernelEdge); }
+
+    /// <summary>
+    /// Retrieves the span buffer written by Emulate. After a dispatch, the spans are read back from the GPU instead.
+    /// </summary>
+    /// <returns>A pointer to the first span</returns>
+    const SlopeKernelSpan *Spans() const { return m_spans.data(); }
+
+    /// <summary>
+    /// Retrieves the total number of spans of the edges in the batch.
+    /// </summary>
+    /// <returns>The number of spans</returns>
+    size_t SpanCount() const { return m_spans.size(); }
+
+    /// <summary>
+    /// Retrieves the size of the span buffer.
+    /// </summary>
+    /// <returns>The size of the span buffer in bytes</returns>
+    size_t SpanBufferSize() const { return m_spans.size() * sizeof(SlopeKernelSpan); }
+
+    /// <summary>
+    /// Computes the number of workgroups to dispatch to process every edge in the batch.
+    /// </summary>
+    /// <returns>The number of workgroups along X</returns>
+    size_t WorkgroupCount() const { return (m_edges.size() + kWorkgroupSize - 1) / kWorkgroupSize; }
+
+private:
+    std::vector<SlopeKernelEdge> m_edges; // Edges of the batch
+    std::vector<SlopeKernelSpan> m_spans; // Spans of every edge, written by Emulate
+};
@@ -0,0 +1,246 @@
+#include "instrument.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The blocks of every thread that has used the instrumentation
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<InstrumentThread>> threads;
+    std::vector<InstrumentThread *> released;               // Blocks of exited threads, ready to be reused
+    std::array<uint64_t, kInstrumentCounterCount> retired{}; // Counters of exited threads
+    Clock::time_point epoch = Clock::now();                  // Origin of the timestamps of trace events
+};
+
+// The registry is never destroyed, so that threads still running during static destruction can keep counting
+Registry &GetRegistry() {
+    static Registry *registry = new Registry;
+    return *registry;
+}
+
+int64_t Microseconds(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+std::array<uint64_t, kInstrumentCounterCount> LoadCounters(const InstrumentThread &thread) {
+    std::array<uint64_t, kInstrumentCounterCount> counters;
+    for (size_t i = 0; i < kInstrumentCounterCount; i++) {
+        counters[i] = thread.counters[i].load(std::memory_order_relaxed);
+    }
+    return counters;
+}
+
+// Copies the counters of the threads that own a block. The registry must be locked.
+std::vector<InstrumentSnapshot> SnapshotThreads(const Registry &registry) {
+    std::vector<InstrumentSnapshot> snapshots;
+    for (auto &thread : registry.threads) {
+        if (thread->owned) {
+            snapshots.push_back({thread->id, LoadCounters(*thread)});
+        }
+    }
+    return snapshots;
+}
+
+// Adds the counters of the running threads to those of the exited threads
+std::array<uint64_t, kInstrumentCounterCount> SumCounters(const std::vector<InstrumentSnapshot> &snapshots,
+                                                          std::array<uint64_t, kInstrumentCounterCount> totals) {
+    for (const InstrumentSnapshot &snapshot : snapshots) {
+        for (size_t i = 0; i < kInstrumentCounterCount; i++) {
+            totals[i] += snapshot.counters[i];
+        }
+    }
+    return totals;
+}
+
+void WriteString(std::ostream &out, const char *str) {
+    out << '"';
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\') {
+            out << '\\';
+        }
+        out << *str;
+    }
+    out << '"';
+}
+
+// Writes the counters as the members of a JSON object
+void WriteCounters(std::ostream &out, const std::array<uint64_t, kInstrumentCounterCount> &counters) {
+    out << "{";
+    for (size_t i = 0; i < kInstrumentCounterCount; i++) {
+        out << (i > 0 ? ", " : "");
+        WriteString(out, InstrumentCounterName((InstrumentCounter)i));
+        out << ": " << counters[i];
+    }
+    out << "}";
+}
+
+// Writes a counter event of the Chrome trace event format. Counter tracks are per process, so each thread gets its own.
+void WriteCounterEvent(std::ostream &out, uint32_t thread, int64_t timestamp,
+                       const std::array<uint64_t, kInstrumentCounterCount> &counters) {
+    out << "{\"name\": \"Thread " << thread << " counters\", \"ph\": \"C\", \"pid\": 1, \"tid\": " << thread
+        << ", \"ts\": " << timestamp << ", \"args\": ";
+    WriteCounters(out, counters);
+    out << "}";
+}
+
+} // namespace
+
+const char *InstrumentCounterName(InstrumentCounter counter) {
+    switch (counter) {
+    case InstrumentCounter::Setups: return "setups";
+    case InstrumentCounter::XMajorEdges: return "xMajorEdges";
+    case InstrumentCounter::YMajorEdges: return "yMajorEdges";
+    case InstrumentCounter::NegativeSlopes: return "negativeSlopes";
+    case InstrumentCounter::Spans: return "spans";
+    case InstrumentCounter::Gaps: return "gaps";
+    case InstrumentCounter::OffscreenScanlines: return "offscreenScanlines";
+    default: return "?";
+    }
+}
+
+InstrumentThread &RegisterInstrumentThread() {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    InstrumentThread *thread;
+    if (!registry.released.empty()) {
+        thread = registry.released.back();
+        registry.released.pop_back();
+    } else {
+        thread = registry.threads.emplace_back(std::make_unique<InstrumentThread>()).get();
+        thread->id = (uint32_t)registry.threads.size();
+    }
+    thread->owned = true;
+    return *thread;
+}
+
+// The counters are moved to the retired totals, so that the next thread to use the block starts from zero. Its trace
+// events are kept for the trace file.
+void ReleaseInstrumentThread(InstrumentThread &thread) {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    for (size_t i = 0; i < kInstrumentCounterCount; i++) {
+        registry.retired[i] += thread.counters[i].exchange(0, std::memory_order_relaxed);
+    }
+    thread.owned = false;
+    registry.released.push_back(&thread);
+}
+
+// The thread is registered before the start time is taken, so that the first scope does not precede the epoch
+InstrumentScope::InstrumentScope(const char *name)
+    : m_thread(InstrumentLocalThread())
+    , m_name(name)
+    , m_start(Clock::now()) {}
+
+InstrumentScope::~InstrumentScope() {
+    const Clock::time_point end = Clock::now();
+    if (m_thread.events.size() >= InstrumentThread::kMaxEvents) {
+        m_thread.droppedEvents++;
+        return;
+    }
+    const int64_t start = Microseconds(m_start - GetRegistry().epoch);
+    m_thread.events.push_back({m_name, start, Microseconds(end - m_start), LoadCounters(m_thread)});
+}
+
+std::vector<InstrumentSnapshot> InstrumentSnapshots() {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    return SnapshotThreads(registry);
+}
+
+std::array<uint64_t, kInstrumentCounterCount> InstrumentRetired() {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    return registry.retired;
+}
+
+std::array<uint64_t, kInstrumentCounterCount> InstrumentTotals() {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    return SumCounters(SnapshotThreads(registry), registry.retired);
+}
+
+void ResetInstrument() {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    for (auto &thread : registry.threads) {
+        for (auto &counter : thread->counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        thread->events.clear();
+        thread->droppedEvents = 0;
+    }
+    registry.retired = {};
+    registry.epoch = Clock::now();
+}
+
+bool WriteInstrumentJSON(const char *path) {
+    std::ofstream out{path};
+    if (!out) {
+        return false;
+    }
+
+    Registry &registry = GetRegistry();
+    std::unique_lock lock{registry.mutex};
+    const std::vector<InstrumentSnapshot> snapshots = SnapshotThreads(registry);
+    const std::array<uint64_t, kInstrumentCounterCount> retired = registry.retired;
+    lock.unlock();
+
+    out << "{\n  \"enabled\": " << (kInstrumentEnabled ? "true" : "false") << ",\n  \"totals\": ";
+    WriteCounters(out, SumCounters(snapshots, retired));
+    out << ",\n  \"retired\": ";
+    WriteCounters(out, retired);
+    out << ",\n  \"threads\": [";
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        out << (i > 0 ? ",\n" : "\n") << "    {\"id\": " << snapshots[i].thread << ", \"counters\": ";
+        WriteCounters(out, snapshots[i].counters);
+        out << "}";
+    }
+    out << (snapshots.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    return (bool)out;
+}
+
+bool WriteInstrumentTrace(const char *path) {
+    std::ofstream out{path};
+    if (!out) {
+        return false;
+    }
+
+    Registry &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    const int64_t now = Microseconds(Clock::now() - registry.epoch);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    auto separate = [&] {
+        out << (first ? "  " : ",\n  ");
+        first = false;
+    };
+    for (auto &thread : registry.threads) {
+        separate();
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->id
+            << ", \"args\": {\"name\": \"Thread " << thread->id << "\"}}";
+        for (const InstrumentThread::Event &event : thread->events) {
+            separate();
+            out << "{\"name\": ";
+            WriteString(out, event.name);
+            out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->id << ", \"ts\": " << event.start
+                << ", \"dur\": " << event.duration << "}";
+            separate();
+            WriteCounterEvent(out, thread->id, event.start + event.duration, event.counters);
+        }
+        if (thread->droppedEvents > 0) {
+            separate();
+            out << "{\"name\": \"" << thread->droppedEvents << " scopes not recorded\", \"ph\": \"i\", \"s\": \"t\", "
+                << "\"pid\": 1, \"tid\": " << thread->id << ", \"ts\": " << now << "}";
+        }
+        separate();
+        WriteCounterEvent(out, thread->id, now, LoadCounters(*thread));
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Optional instrumentation of the interpolation and rasterization hot paths.
+//
+// Define NDS_INTERP_INSTRUMENT for the whole build to enable it. Without it, the NDS_INTERP_COUNT macros and
+// NDS_INTERP_TRACE_SCOPE expand to nothing and their arguments are not evaluated, so instrumented code compiles to
+// exactly the same machine code as uninstrumented code. The export functions remain available and report no threads.
+
+#ifdef NDS_INTERP_INSTRUMENT
+constexpr bool kInstrumentEnabled = true;
+#else
+constexpr bool kInstrumentEnabled = false;
+#endif
+
+// Determines if the enclosing constexpr function is being evaluated at compile time, in which case the counters
+// cannot be touched
+#if defined(__cpp_lib_is_constant_evaluated)
+    #define NDS_INTERP_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+    #define NDS_INTERP_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+    #define NDS_INTERP_IS_CONSTANT_EVALUATED() false
+#endif
+
+/// <summary>
+/// The events counted by the instrumentation.
+/// </summary>
+enum class InstrumentCounter {
+    Setups,             // Slopes configured by Slope::Setup or SlopeBatch::Setup
+    XMajorEdges,        // Configured slopes that are X-major
+    YMajorEdges,        // Configured slopes that are Y-major, including diagonals
+    NegativeSlopes,     // Configured slopes that are negative
+    Spans,              // Spans produced by span generators and by Rasterizer
+    Gaps,               // One-pixel gaps between consecutive spans found by Slope::GenerateRuns
+    OffscreenScanlines, // Scanlines skipped because their spans are out of view
+
+    Count,
+};
+
+/// <summary>
+/// The number of counters.
+/// </summary>
+constexpr size_t kInstrumentCounterCount = (size_t)InstrumentCounter::Count;
+
+/// <summary>
+/// Retrieves the name of a counter, as used in the exported files.
+/// </summary>
+/// <param name="counter">The counter</param>
+/// <returns>The name of the counter in camelCase</returns>
+const char *InstrumentCounterName(InstrumentCounter counter);
+
+/// <summary>
+/// The counters and trace events recorded by one thread.
+/// </summary>
+/// <remarks>
+/// Each thread owns its block, so counting is a plain load and store without contention. The counters are atomic so
+/// that they can be read while the thread is still running. When a thread exits, its counters are added to the retired
+/// totals and its block is handed to the next thread that starts counting, along with its ID and trace events. The
+/// number of blocks is therefore bounded by the number of threads running at once, even if short-lived workers, such
+/// as those of ParallelFor, are started every frame.
+/// </remarks>
+struct InstrumentThread {
+    /// <summary>
+    /// A completed trace scope.
+    /// </summary>
+    struct Event {
+        const char *name;                                       // Name of the scope, which must be a string literal
+        int64_t start;                                          // Start time in microseconds since the first thread
+        int64_t duration;                                       // Duration in microseconds
+        std::array<uint64_t, kInstrumentCounterCount> counters; // Counters of the thread when the scope ended
+    };
+
+    /// <summary>
+    /// The maximum number of trace events recorded per thread. Further scopes are counted but not recorded.
+    /// </summary>
+    static constexpr size_t kMaxEvents = 1 << 16;
+
+    uint32_t id = 0;                                                       // Sequential ID of the block, from 1
+    std::array<std::atomic<uint64_t>, kInstrumentCounterCount> counters{}; // Counters of the owning thread
+    std::vector<Event> events;                                             // Trace events of every owning thread
+    size_t droppedEvents = 0;                                              // Scopes not recorded past kMaxEvents
+    bool owned = false;                                                    // True while a thread owns the block
+};
+
+/// <summary>
+/// Assigns an instrumentation block to a new thread, reusing the block of an exited thread if there is one. Use
+/// InstrumentLocalThread instead.
+/// </summary>
+/// <returns>The block, which lives until the program exits</returns>
+InstrumentThread &RegisterInstrumentThread();
+
+/// <summary>
+/// Adds the counters of an exiting thread to the retired totals and makes its block available to the next thread.
+/// Called when the thread that registered the block exits.
+/// </summary>
+/// <param name="thread">The block of the exiting thread</param>
+void ReleaseInstrumentThread(InstrumentThread &thread);
+
+/// <summary>
+/// Owns the instrumentation block of a thread from its registration until the thread exits.
+/// </summary>
+class InstrumentThreadOwner {
+public:
+    /// <summary>
+    /// Registers the block of the calling thread.
+    /// </summary>
+    InstrumentThreadOwner()
+        : m_thread(RegisterInstrumentThread()) {}
+
+    /// <summary>
+    /// Releases the block of the exiting thread.
+    /// </summary>
+    ~InstrumentThreadOwner() { ReleaseInstrumentThread(m_thread); }
+
+    InstrumentThreadOwner(const InstrumentThreadOwner &) = delete;
+    InstrumentThreadOwner &operator=(const InstrumentThreadOwner &) = delete;
+
+    /// <summary>
+    /// Retrieves the owned block.
+    /// </summary>
+    /// <returns>The block of the thread</returns>
+    InstrumentThread &Thread() const { return m_thread; }
+
+private:
+    InstrumentThread &m_thread; // Block of the thread
+};
+
+/// <summary>
+/// Retrieves the instrumentation block of the calling thread, registering it on first use.
+/// </summary>
+/// <remarks>
+/// The block is released when the thread exits, so this must not be called from the destructors of other thread-local
+/// objects.
+/// </remarks>
+/// <returns>The block of the calling thread</returns>
+inline InstrumentThread &InstrumentLocalThread() {
+    thread_local InstrumentThreadOwner owner;
+    return owner.Thread();
+}
+
+/// <summary>
+/// Adds to a counter of the calling thread.
+/// </summary>
+/// <param name="counter">The counter to increase</param>
+/// <param name="amount">The amount to add</param>
+inline void InstrumentAdd(InstrumentCounter counter, uint64_t amount) {
+    std::atomic<uint64_t> &value = InstrumentLocalThread().counters[(size_t)counter];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Records the duration of a block of code as a trace event of the calling thread, along with its counters.
+/// </summary>
+class InstrumentScope {
+public:
+    /// <summary>
+    /// Starts the scope.
+    /// </summary>
+    /// <param name="name">The name of the scope, which must be a string literal</param>
+    explicit InstrumentScope(const char *name);
+
+    /// <summary>
+    /// Ends the scope and records its event.
+    /// </summary>
+    ~InstrumentScope();
+
+    InstrumentScope(const InstrumentScope &) = delete;
+    InstrumentScope &operator=(const InstrumentScope &) = delete;
+
+private:
+    InstrumentThread &m_thread;                    // Block of the thread that started the scope
+    const char *m_name;                            // Name of the scope
+    std::chrono::steady_clock::time_point m_start; // Time at which the scope started
+};
+
+#ifdef NDS_INTERP_INSTRUMENT
+    // Adds amount to the specified InstrumentCounter of the calling thread. Safe to use in constexpr functions.
+    #define NDS_INTERP_COUNT(counter, amount)                                                                          \
+        do {                                                                                                           \
+            if (!NDS_INTERP_IS_CONSTANT_EVALUATED()) {                                                                 \
+                InstrumentAdd(InstrumentCounter::counter, (uint64_t)(amount));                                         \
+            }                                                                                                          \
+        } while (false)
+
+    // Counts the setup of a slope with the specified orientation
+    #define NDS_INTERP_COUNT_SETUP(negative, xMajor)                                                                   \
+        do {                                                                                                           \
+            NDS_INTERP_COUNT(Setups, 1);                                                                               \
+            NDS_INTERP_COUNT(XMajorEdges, (xMajor));                                                                   \
+            NDS_INTERP_COUNT(YMajorEdges, !(xMajor));                                                                  \
+            NDS_INTERP_COUNT(NegativeSlopes, (negative));                                                              \
+        } while (false)
+
+    #define NDS_INTERP_CONCAT_IMPL(a, b) a##b
+    #define NDS_INTERP_CONCAT(a, b) NDS_INTERP_CONCAT_IMPL(a, b)
+
+    // Records the rest of the enclosing block as a trace event with the specified name
+    #define NDS_INTERP_TRACE_SCOPE(name) InstrumentScope NDS_INTERP_CONCAT(instrumentScope, __LINE__){name}
+#else
+    #define NDS_INTERP_COUNT(counter, amount) ((void)0)
+    #define NDS_INTERP_COUNT_SETUP(negative, xMajor) ((void)0)
+    #define NDS_INTERP_TRACE_SCOPE(name) ((void)0)
+#endif
+
+/// <summary>
+/// A copy of the counters of one thread.
+/// </summary>
+struct InstrumentSnapshot {
+    uint32_t thread;                                        // ID of the block of the thread
+    std::array<uint64_t, kInstrumentCounterCount> counters; // Counters of the thread
+};
+
+/// <summary>
+/// Copies the counters of every running thread that has used the instrumentation.
+/// </summary>
+/// <returns>The counters of each thread, ordered by block ID</returns>
+std::vector<InstrumentSnapshot> InstrumentSnapshots();
+
+/// <summary>
+/// Adds up the counters of every thread that has exited after using the instrumentation.
+/// </summary>
+/// <returns>The retired total of each counter</returns>
+std::array<uint64_t, kInstrumentCounterCount> InstrumentRetired();
+
+/// <summary>
+/// Adds up the counters of every thread that has used the instrumentation, whether it is still running or not.
+/// </summary>
+/// <returns>The total of each counter</returns>
+std::array<uint64_t, kInstrumentCounterCount> InstrumentTotals();
+
+/// <summary>
+/// Clears the counters, the retired totals and the trace events of every thread. Must not run concurrently with
+/// instrumented code.
+/// </summary>
+void ResetInstrument();
+
+/// <summary>
+/// Writes the counters of every thread and their totals to a JSON file.
+/// </summary>
+/// <remarks>
+/// The file contains an object with a "totals" object mapping each counter name to its total, a "retired" object with
+/// the counters of the threads that have exited and a "threads" array with the ID and counters of each running thread.
+/// </remarks>
+/// <param name="path">The path of the file to write</param>
+/// <returns>true if the file was written</returns>
+bool WriteInstrumentJSON(const char *path);
+
+/// <summary>
+/// Writes the trace events and counters of every thread to a file in the Chrome trace event format.
+/// </summary>
+/// <remarks>
+/// The file can be loaded into chrome://tracing or Perfetto. Each trace scope becomes a complete event on the track of
+/// its thread, followed by a counter event with the counters of the thread when the scope ended, so the counters show
+/// up as graphs over time. A final counter event per thread records the current counters. Threads that reuse the block
+/// of an exited thread share its track, on which their scopes follow one another. Must not run concurrently with trace
+/// scopes.
+/// </remarks>
+/// <param name="path">The path of the file to write</param>
+/// <returns>true if the file was written</returns>
+bool WriteInstrumentTrace(const char *path);
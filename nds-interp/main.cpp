@@ -1,148 +1,281 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
+#include "benchmark.h"
+#include "capture_codec.h"
+#include "fuzzer.h"
+#include "instrument.h"
+#include "mapped_file.h"
+#include "parallel.h"
 #include "slope.h"
+#include "span_lut.h"
 
 using u8 = uint8_t;
 using u16 = uint16_t;
 using u32 = uint32_t;
+using u64 = uint64_t;
 using i32 = int32_t;
 
-template <typename T>
-std::vector<T> LoadBin(const std::filesystem::path &path) {
-    std::basic_ifstream<T> file{path, std::ios::binary};
-    return {std::istreambuf_iterator<T>{file}, {}};
-}
-
-struct membuf : std::streambuf {
-    membuf(char *begin, char *end) { this->setg(begin, begin, end); }
-};
-
 struct Span {
     bool exists;
     u8 start, end;
 };
 
-struct Line {
-    std::array<Span, 192> spans;
-};
+// Header of a data file
+struct DataHeader {
+    static constexpr size_t kSize = 7;
 
-struct Data {
     u8 type;
     u16 minX, maxX;
     u8 minY, maxY;
-    std::array<std::array<Line, 256 + 1>, 192 + 1> lines;
 };
 
-std::unique_ptr<Data> readFile(std::filesystem::path path) {
-    if (!std::filesystem::is_regular_file(path)) {
-        std::cout << path.string() << " does not exist or is not a file.\n";
-        return nullptr;
-    }
+// Location of a slope's spans in a dataset
+struct SlopeSpans {
+    u32 offset = 0;   // Byte offset of the first span
+    u8 firstLine = 0; // Y coordinate of the first span
+    u8 count = 0;     // Number of spans
+};
 
-    std::cout << "Loading " << path.string() << "... ";
-    std::vector<char> buffer = LoadBin<char>(path);
-    membuf mbuf(buffer.data(), buffer.data() + buffer.size());
-    std::istream in{&mbuf};
+// Spans captured from every slope of a dataset, read in place from the memory-mapped data file.
+//
+// Only the location of each slope's spans in the file is stored; the spans themselves are read straight from the
+// mapping when queried. Compressed files are decompressed into memory once and read from there instead.
+struct MappedData : DataHeader {
+    static constexpr int kSlopesX = 256 + 1;
+    static constexpr int kSlopesY = 192 + 1;
+
+    MappedFile file;
+    std::vector<u8> decompressed; // Raw contents of a compressed file
+    std::vector<SlopeSpans> slopes = std::vector<SlopeSpans>(kSlopesX * kSlopesY);
+
+    // Retrieves the raw contents of the data file
+    const u8 *Bytes() const { return decompressed.empty() ? file.Data() : decompressed.data(); }
 
-    auto pData = std::make_unique<Data>();
-    auto &lines = pData->lines;
+    // Retrieves the size of the raw contents of the data file
+    size_t Size() const { return decompressed.empty() ? file.Size() : decompressed.size(); }
 
-    in.read((char *)&pData->type, 1);
-    in.read((char *)&pData->minX, sizeof(pData->minX));
-    in.read((char *)&pData->maxX, sizeof(pData->maxX));
-    in.read((char *)&pData->minY, sizeof(pData->minY));
-    in.read((char *)&pData->maxY, sizeof(pData->maxY));
+    // Retrieves the span captured for scanline Y of slope (slopeX, slopeY). Returns a nonexistent span if the
+    // scanline was not captured.
+    Span GetSpan(int slopeX, int slopeY, int y) const {
+        const SlopeSpans &slope = slopes[slopeY * kSlopesX + slopeX];
+        const int index = y - slope.firstLine;
+        if (index < 0 || index >= slope.count) {
+            return {false, 0, 0};
+        }
+        const u8 *span = Bytes() + slope.offset + index * 3;
+        return {span[0] != 0, span[1], span[2]};
+    }
+};
 
-    switch (pData->type) {
+// Parses the header of a data file and prints a description of its contents
+bool readHeader(const u8 *bytes, size_t size, DataHeader &header) {
+    if (size < DataHeader::kSize) {
+        std::cout << " -- Invalid file\n";
+        return false;
+    }
+
+    header.type = bytes[0];
+    header.minX = bytes[1] | (bytes[2] << 8);
+    header.maxX = bytes[3] | (bytes[4] << 8);
+    header.minY = bytes[5];
+    header.maxY = bytes[6];
+
+    switch (header.type) {
     case 0: std::cout << "Top left"; break;
     case 1: std::cout << "Bottom left"; break;
     case 2: std::cout << "Top right"; break;
     case 3: std::cout << "Bottom right"; break;
-    default: std::cout << "Invalid type (" << (int)pData->type << ")"; return nullptr;
+    default: std::cout << "Invalid type (" << (int)header.type << ")"; return false;
+    }
+    std::cout << ", " << header.minX << "x" << (int)header.minY << " to " << header.maxX << "x" << (int)header.maxY;
+
+    if (header.maxX >= MappedData::kSlopesX || header.maxY >= MappedData::kSlopesY) {
+        std::cout << " -- Invalid file\n";
+        return false;
     }
-    std::cout << ", " << pData->minX << "x" << (int)pData->minY << " to " << pData->maxX << "x" << (int)pData->maxY;
+    return true;
+}
+
+// Walks the slope records of the raw contents of a data file in a single pass, invoking
+// fn(slopeX, slopeY, startY, endY, spans) for each record, where spans points to the (exists, start, end) triplets of
+// scanlines startY..endY in the file. Returns false if the file is truncated or malformed.
+template <typename Fn>
+bool forEachRecord(const u8 *data, size_t size, const DataHeader &header, Fn &&fn) {
+    const u8 *pos = data + DataHeader::kSize;
+    const u8 *end = data + size;
+
+    auto record = [&](int slopeX, int slopeY, int startY, int endY) {
+        const size_t recordSize = (size_t)(endY - startY + 1) * 3;
+        if ((size_t)(end - pos) < recordSize) {
+            return false;
+        }
+        fn(slopeX, slopeY, startY, endY, pos);
+        pos += recordSize;
+        return true;
+    };
 
-    u8 coords[2];
     int prevX = 0;
     int prevY = 0;
-    for (int y = pData->minY; y <= pData->maxY; y++) {
-        for (int x = pData->minX; x <= pData->maxX; x++) {
-            in.read((char *)coords, sizeof(coords));
-            if (coords[0] != (u8)prevX || coords[1] != (u8)prevY) {
-                std::cout << " -- Invalid file\n";
-                return nullptr;
+    for (int y = header.minY; y <= header.maxY; y++) {
+        for (int x = header.minX; x <= header.maxX; x++) {
+            if (end - pos < 2 || pos[0] != (u8)prevX || pos[1] != (u8)prevY) {
+                return false;
             }
-            int startY = (pData->type & 2) ? prevY : 0;
-            int endY = (pData->type & 2) ? 191 : prevY;
+            pos += 2;
+            int startY = (header.type & 2) ? prevY : 0;
+            int endY = (header.type & 2) ? 191 : prevY;
             if (startY >= 192) startY = 191;
             if (endY >= 192) endY = 191;
-            for (int checkY = startY; checkY <= endY; checkY++) {
-                Span &span = lines[prevY][prevX].spans[checkY];
-                in.read((char *)&span.exists, 1);
-                in.read((char *)&span.start, 1);
-                in.read((char *)&span.end, 1);
+            if (!record(prevX, prevY, startY, endY)) {
+                return false;
             }
             prevX = x;
             prevY = y;
         }
     }
 
-    int startY = (pData->type & 2) ? std::min((int)pData->minY, 191) : 0;
-    int endY = (pData->type & 2) ? 191 : std::min((int)pData->maxY, 191);
-    for (int y = startY; y <= endY; y++) {
-        Span &span = lines[prevY][prevX].spans[y];
-        in.read((char *)&span.exists, 1);
-        in.read((char *)&span.start, 1);
-        in.read((char *)&span.end, 1);
+    // The last record has no coordinates
+    int startY = (header.type & 2) ? std::min(prevY, 191) : 0;
+    int endY = (header.type & 2) ? 191 : std::min(prevY, 191);
+    return record(prevX, prevY, startY, endY);
+}
+
+// Maps a data file into memory and indexes the spans of each slope without copying them. Compressed files are
+// decompressed into memory first.
+std::unique_ptr<MappedData> mapFile(std::filesystem::path path) {
+    if (!std::filesystem::is_regular_file(path)) {
+        std::cout << path.string() << " does not exist or is not a file.\n";
+        return nullptr;
+    }
+
+    std::cout << "Loading " << path.string() << "... ";
+    auto pData = std::make_unique<MappedData>();
+    if (!pData->file.Open(path)) {
+        std::cout << "could not map file\n";
+        return nullptr;
+    }
+    if (CaptureCodec::IsCompressed(pData->file.Data(), pData->file.Size())) {
+        if (!CaptureCodec::Decompress(pData->file.Data(), pData->file.Size(), pData->decompressed)) {
+            std::cout << "invalid compressed file\n";
+            return nullptr;
+        }
+        pData->file.Close();
+        std::cout << "(compressed) ";
+    }
+    if (!readHeader(pData->Bytes(), pData->Size(), *pData)) {
+        return nullptr;
+    }
+
+    const u8 *base = pData->Bytes();
+    bool valid = forEachRecord(base, pData->Size(), *pData, [&](int slopeX, int slopeY, int startY, int endY,
+                                                                const u8 *spans) {
+        SlopeSpans &slope = pData->slopes[slopeY * MappedData::kSlopesX + slopeX];
+        slope.offset = (u32)(spans - base);
+        slope.firstLine = (u8)startY;
+        slope.count = (u8)(endY - startY + 1);
+    });
+    if (!valid) {
+        std::cout << " -- Invalid file\n";
+        return nullptr;
     }
 
     std::cout << " -- OK\n";
 
-    return std::move(pData);
+    return pData;
 }
 
-// Converts the raw screen capture taken from the NDS into a TGA file
-void convertScreenCap(std::filesystem::path binPath, std::filesystem::path tgaPath) {
-    std::ifstream in{binPath, std::ios::binary};
-    std::ofstream out{tgaPath, std::ios::binary | std::ios::trunc};
+// Compresses a raw data file into the format read by CaptureCodec. mapFile and streamFile accept either format.
+bool compressFile(std::filesystem::path rawPath, std::filesystem::path compressedPath) {
+    std::cout << "Compressing " << rawPath.string() << "... ";
+    MappedFile file;
+    std::vector<u8> compressed;
+    if (!file.Open(rawPath) || !CaptureCodec::Compress(file.Data(), file.Size(), compressed)) {
+        std::cout << "invalid file\n";
+        return false;
+    }
 
-    u8 tga[18];
-    std::fill_n(tga, 18, 0);
-    tga[2] = 2;                               // uncompressed truecolor
+    std::ofstream out{compressedPath, std::ios::binary | std::ios::trunc};
+    out.write((const char *)compressed.data(), compressed.size());
+    if (!out) {
+        std::cout << "could not write " << compressedPath.string() << "\n";
+        return false;
+    }
+    std::cout << file.Size() << " -> " << compressed.size() << " bytes\n";
+    return true;
+}
+
+// Origin of the slopes in each type of dataset
+struct Origin {
+    i32 x, y;
+    const char *name;
+    const char *shortName; // Name of the data file and of the dataset in the golden manifest
+};
+
+Origin getOrigin(u8 type) {
+    switch (type) {
+    case 0: return {0, 0, "top left", "TL"};
+    case 1: return {256, 0, "top right", "TR"};
+    case 2: return {0, 192, "bottom left", "BL"};
+    default: return {256, 192, "bottom right", "BR"};
+    }
+}
+
+// Size of the header of a TGA file
+constexpr size_t kTGAHeaderSize = 18;
+
+// Writes the header of an uncompressed 256x192 TGA image, stored top to bottom, left to right
+void writeTGAHeader(u8 *tga, u8 imageType, u8 bitsPerPixel) {
+    std::fill_n(tga, kTGAHeaderSize, 0);
+    tga[2] = imageType;                       // image type
     *reinterpret_cast<u16 *>(&tga[12]) = 256; // width
     *reinterpret_cast<u16 *>(&tga[14]) = 192; // height
-    tga[16] = 24;                             // bits per pixel
+    tga[16] = bitsPerPixel;                   // bits per pixel
     tga[17] = 32;                             // image descriptor: top to bottom, left to right
+}
 
-    out.write((char *)tga, sizeof(tga));
-
-    u16 clr;
-    for (size_t y = 0; y < 192; y++) {
-        for (size_t x = 0; x < 256; x++) {
-            in.read((char *)&clr, sizeof(clr));
-            u8 r5 = (clr >> 0) & 0x1F;
-            u8 g5 = (clr >> 5) & 0x1F;
-            u8 b5 = (clr >> 10) & 0x1F;
-            u8 r8 = (r5 << 3) | (r5 >> 2);
-            u8 g8 = (g5 << 3) | (g5 >> 2);
-            u8 b8 = (b5 << 3) | (b5 >> 2);
-            out.write((char *)&b8, sizeof(b8));
-            out.write((char *)&g8, sizeof(g8));
-            out.write((char *)&r8, sizeof(r8));
-        }
+// Converts RGB555 colors to the BGR888 pixels of a truecolor TGA image. Each iteration is independent so that the
+// loop can be vectorized.
+void convertRGB555(const u16 *colors, size_t count, u8 *pixels) {
+    for (size_t i = 0; i < count; i++) {
+        const u16 clr = colors[i];
+        const u8 r5 = (clr >> 0) & 0x1F;
+        const u8 g5 = (clr >> 5) & 0x1F;
+        const u8 b5 = (clr >> 10) & 0x1F;
+        pixels[i * 3 + 0] = (b5 << 3) | (b5 >> 2);
+        pixels[i * 3 + 1] = (g5 << 3) | (g5 >> 2);
+        pixels[i * 3 + 2] = (r5 << 3) | (r5 >> 2);
     }
 }
 
+// Converts the raw screen capture taken from the NDS into a TGA file
+void convertScreenCap(std::filesystem::path binPath, std::filesystem::path tgaPath) {
+    constexpr size_t kPixels = 256 * 192;
+
+    std::vector<u16> colors(kPixels);
+    std::ifstream in{binPath, std::ios::binary};
+    in.read((char *)colors.data(), kPixels * sizeof(u16));
+
+    std::vector<u8> tga(kTGAHeaderSize + kPixels * 3);
+    writeTGAHeader(tga.data(), 2, 24); // uncompressed truecolor
+    convertRGB555(colors.data(), kPixels, &tga[kTGAHeaderSize]);
+
+    std::ofstream out{tgaPath, std::ios::binary | std::ios::trunc};
+    out.write((char *)tga.data(), tga.size());
+}
+
 // Lists all unique colors present in the raw screen capture taken from the NDS
 void uniqueColors(std::filesystem::path binPath) {
     std::ifstream in{binPath, std::ios::binary};
@@ -168,51 +301,136 @@ void uniqueColors(std::filesystem::path binPath) {
     std::cout << "\n";
 }
 
-// Writes a series of TGA files with a rendering of every scanline captured from the NDS in the given data file
-void writeImages(Data &data, std::filesystem::path outDir) {
-    auto &lines = data.lines;
+// Size of a TGA file with a greyscale rendering of the spans of a slope
+constexpr size_t kSpanImageSize = kTGAHeaderSize + 256 * 192;
 
-    u8 tga[18];
-    std::fill_n(tga, 18, 0);
-    tga[2] = 3;                               // uncompressed greyscale
-    *reinterpret_cast<u16 *>(&tga[12]) = 256; // width
-    *reinterpret_cast<u16 *>(&tga[14]) = 192; // height
-    tga[16] = 8;                              // bits per pixel
-    tga[17] = 32;                             // image descriptor: top to bottom, left to right
+// Renders every scanline of a slope captured from the NDS into a greyscale TGA file, writing each pixel once
+template <typename TData>
+void renderSpanImage(const TData &data, i32 sizeX, i32 sizeY, u8 *tga) {
+    writeTGAHeader(tga, 3, 8); // uncompressed greyscale
+    u8 *pixels = tga + kTGAHeaderSize;
+    for (i32 y = 0; y < 192; y++) {
+        u8 *row = &pixels[y * 256];
+        const Span span = data.GetSpan(sizeX, sizeY, y);
+        if (span.exists) {
+            std::fill(row, row + span.start, 0);
+            std::fill(row + span.start, row + span.end + 1, 255);
+            std::fill(row + span.end + 1, row + 256, 0);
+        } else {
+            std::fill(row, row + 256, 0);
+        }
+    }
+}
 
-    for (size_t sizeY = data.minY; sizeY <= data.maxY; sizeY++) {
-        for (size_t sizeX = data.minX; sizeX <= data.maxX; sizeX++) {
-            u8 pixels[192][256];
-            memset(pixels, 0, 256 * 192);
-            for (size_t y = 0; y < 192; y++) {
-                Span &span = lines[sizeY][sizeX].spans[y];
-                if (span.exists) {
-                    for (size_t x = span.start; x <= span.end; x++) {
-                        pixels[y][x] = 255;
-                    }
-                }
-            }
+// Builds the file name of the rendering of a slope
+std::string spanImageName(u8 type, i32 sizeX, i32 sizeY) {
+    return std::string(getOrigin(type).shortName) + "-" + std::to_string(sizeX) + "x" + std::to_string(sizeY) + ".tga";
+}
 
-            std::string name;
-            switch (data.type) {
-            case 0: name = "TL"; break;
-            case 1: name = "TR"; break;
-            case 2: name = "BL"; break;
-            case 3: name = "BR"; break;
-            }
+// Writes a series of TGA files with a rendering of every scanline captured from the NDS in the given data file. Each
+// row of slopes is rendered and written by a separate worker, so file I/O overlaps with rendering.
+template <typename TData>
+void writeImages(const TData &data, std::filesystem::path outDir) {
+    std::filesystem::create_directories(outDir);
+    ParallelFor(data.maxY - data.minY + 1, [&](size_t row) {
+        const i32 sizeY = data.minY + (i32)row;
+        std::vector<u8> tga(kSpanImageSize);
+        for (i32 sizeX = data.minX; sizeX <= data.maxX; sizeX++) {
+            renderSpanImage(data, sizeX, sizeY, tga.data());
+            std::ofstream out{outDir / spanImageName(data.type, sizeX, sizeY), std::ios::binary | std::ios::trunc};
+            out.write((char *)tga.data(), tga.size());
+        }
+    });
+}
+
+// Size of a block of a tar archive
+constexpr size_t kTarBlockSize = 512;
+
+// Size of an entry of an image archive: a header block followed by the image, padded to a whole block
+constexpr size_t kTarEntrySize = kTarBlockSize + (kSpanImageSize + kTarBlockSize - 1) / kTarBlockSize * kTarBlockSize;
+
+// Writes the ustar header of a regular file into a zeroed block
+void writeTarHeader(u8 *block, const std::string &name, size_t size) {
+    auto field = [&](size_t offset, size_t length, const char *value) {
+        std::memcpy(&block[offset], value, std::min(std::strlen(value), length));
+    };
+    auto octal = [&](size_t offset, size_t length, u64 value) {
+        // Zero-padded, followed by a NUL terminator
+        block[offset + length - 1] = '\0';
+        for (size_t i = length - 1; i-- > 0; value >>= 3) {
+            block[offset + i] = '0' + (value & 7);
+        }
+    };
+    field(0, 100, name.c_str());
+    octal(100, 8, 0644); // mode
+    octal(108, 8, 0);    // uid
+    octal(116, 8, 0);    // gid
+    octal(124, 12, size);
+    octal(136, 12, 0); // mtime
+    block[156] = '0';  // regular file
+    field(257, 6, "ustar");
+    field(263, 2, "00");
 
-            std::ostringstream filename;
-            filename << name << "-" << sizeX << "x" << sizeY << ".tga";
+    // The checksum is computed with the checksum field filled with spaces
+    std::fill_n(&block[148], 8, ' ');
+    u32 checksum = 0;
+    for (size_t i = 0; i < kTarBlockSize; i++) {
+        checksum += block[i];
+    }
+    octal(148, 7, checksum);
+}
+
+// Writes the renderings of every slope captured from the NDS in the given data file into a single tar archive, which
+// is much faster to write, copy and delete than tens of thousands of small files. Every entry has the same size, so
+// each row of slopes is rendered by a separate worker and written directly at its final position in the archive.
+template <typename TData>
+bool writeImageArchive(const TData &data, std::filesystem::path path) {
+    const size_t rows = data.maxY - data.minY + 1;
+    const size_t columns = data.maxX - data.minX + 1;
+    const size_t rowSize = columns * kTarEntrySize;
+
+    // The archive ends with two zeroed blocks
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        if (!out) {
+            std::cout << "could not write " << path.string() << "\n";
+            return false;
+        }
+    }
+    std::filesystem::resize_file(path, rows * rowSize + 2 * kTarBlockSize);
+
+    std::atomic<bool> failed{false};
+    ParallelFor(rows, [&](size_t row) {
+        const i32 sizeY = data.minY + (i32)row;
+        std::vector<u8> entries(rowSize, 0);
+        for (size_t column = 0; column < columns; column++) {
+            const i32 sizeX = data.minX + (i32)column;
+            u8 *entry = &entries[column * kTarEntrySize];
+            writeTarHeader(entry, spanImageName(data.type, sizeX, sizeY), kSpanImageSize);
+            renderSpanImage(data, sizeX, sizeY, entry + kTarBlockSize);
+        }
 
-            std::filesystem::create_directories(outDir);
-            std::ofstream out{outDir / filename.str(), std::ios::binary | std::ios::trunc};
-            out.write((char *)tga, sizeof(tga));
-            out.write((char *)pixels, 256 * 192);
+        std::ofstream out{path, std::ios::binary | std::ios::in | std::ios::out};
+        out.seekp(row * rowSize);
+        out.write((char *)entries.data(), entries.size());
+        if (!out) {
+            failed = true;
         }
+    });
+    if (failed) {
+        std::cout << "could not write " << path.string() << "\n";
+        return false;
     }
+    return true;
 }
 
-void testSlope(const Data &data, i32 testX, i32 testY, i32 x0, i32 y0, i32 x1, i32 y1, bool &mismatch) {
+// The area of the screen captured from hardware
+constexpr Slope::ClipRect kScreenClip{0, 0, 256, 192};
+
+// Invokes fn(slope, y, startScrX, endScrX) for every scanline of the slope (X0,Y0)-(X1,Y1) that is compared against
+// the captures, with the span ordered from left to right
+template <typename Fn>
+void forEachTestedSpan(i32 x0, i32 y0, i32 x1, i32 y1, Fn &&fn) {
     // Always rasterize top to bottom
     if (y0 > y1) {
         std::swap(x0, x1);
@@ -222,105 +440,685 @@ void testSlope(const Data &data, i32 testX, i32 testY, i32 x0, i32 y0, i32 x1, i
     // Y0 coinciding with Y1 is equivalent to Y0 and Y1 being 1 pixel apart
     if (y0 == y1) y1++;
 
-    // Helper function that prints the mismatch message on the first occurrence of a mismatch
-    auto foundMismatch = [&] {
-        if (!mismatch) {
-            mismatch = true;
-            std::cout << "found mismatch\n";
-        }
-    };
-
-    // Create and configure the slope
+    // Create and configure the slope, skipping the scanlines out of view
     Slope slope;
-    slope.Setup(x0, y0, x1, y1);
+    const Slope::VisibleRange visible = slope.Setup(x0, y0, x1, y1, kScreenClip);
+    NDS_INTERP_COUNT(OffscreenScanlines, (y1 - y0) - (visible.y1 - visible.y0));
 
-    for (i32 y = y0; y < y1; y++) {
+    for (i32 y = visible.y0; y < visible.y1; y++) {
         // Get span for the current scanline
-        i32 startX = slope.FracXStart(y);
-        i32 endX = slope.FracXEnd(y);
         i32 startScrX = slope.XStart(y);
         i32 endScrX = slope.XEnd(y);
 
         // Spans are reversed when the slope is negative
         if (slope.IsNegative()) {
-            std::swap(startX, endX);
             std::swap(startScrX, endScrX);
         }
 
-        // Skip scanlines out of view
-        if (startScrX >= 256) continue;
-        if (y == 192) break;
+        // Only X-major slopes have gaps, found in the direction of the slope from the previous scanline's span
+        NDS_INTERP_COUNT(Spans, 1);
+        NDS_INTERP_COUNT(Gaps, y > y0 && slope.IsXMajor() &&
+                                   (slope.IsNegative() ? slope.XEnd(y - 1) - slope.XStart(y) > 1
+                                                       : slope.XStart(y) - slope.XEnd(y - 1) > 1));
+        fn(slope, y, startScrX, endScrX);
+    }
+}
+
+template <typename TData>
+void testSlope(const TData &data, i32 testX, i32 testY, i32 x0, i32 y0, i32 x1, i32 y1, std::ostream &out,
+               bool &mismatch) {
+    forEachTestedSpan(x0, y0, x1, y1, [&](const Slope &slope, i32 y, i32 startScrX, i32 endScrX) {
+        i32 startX = slope.FracXStart(y);
+        i32 endX = slope.FracXEnd(y);
+        if (slope.IsNegative()) {
+            std::swap(startX, endX);
+        }
 
         // Compare generated spans with those captured from hardware
-        const Span &span = data.lines[testY][testX].spans[y];
+        const Span span = data.GetSpan(testX, testY, y);
         if (!span.exists) {
-            foundMismatch();
+            mismatch = true;
 
             // clang-format off
-            std::cout << std::setw(3) << testX << "x" << std::setw(3) << testY << " Y=" << std::setw(3) << y << ": span doesn't exist\n";
+            out << std::setw(3) << testX << "x" << std::setw(3) << testY << " Y=" << std::setw(3) << y << ": span doesn't exist\n";
             // clang-format on
         } else if (span.start != startScrX || span.end != endScrX) {
-            foundMismatch();
+            mismatch = true;
 
             // clang-format off
-            std::cout << std::setw(3) << testX << "x" << std::setw(3) << testY << " Y=" << std::setw(3) << y << ": ";
+            out << std::setw(3) << testX << "x" << std::setw(3) << testY << " Y=" << std::setw(3) << y << ": ";
                     
-            std::cout << std::setw(3) << startScrX << ".." << std::setw(3) << endScrX;
-            std::cout << "  !=  ";
-            std::cout << std::setw(3) << (u32)span.start << ".." << std::setw(3) << (u32)span.end;
+            out << std::setw(3) << startScrX << ".." << std::setw(3) << endScrX;
+            out << "  !=  ";
+            out << std::setw(3) << (u32)span.start << ".." << std::setw(3) << (u32)span.end;
                     
-            std::cout << "  (" << std::showpos << (i32)(startScrX - span.start) << ".." << (i32)(endScrX - span.end) << ")" << std::noshowpos;
+            out << "  (" << std::showpos << (i32)(startScrX - span.start) << ".." << (i32)(endScrX - span.end) << ")" << std::noshowpos;
 
-            std::cout << "  raw X = " << std::setw(10) << endX << "  lastX = " << std::setw(10) << startX;
-            std::cout << "  masked X = " << std::setw(10) << (endX % Slope::kOne) << "  lastX = " << std::setw(10) << (startX % Slope::kOne);
-            std::cout << "  inc = " << std::setw(10) << slope.DX();
-            std::cout << "\n";
+            out << "  raw X = " << std::setw(10) << endX << "  lastX = " << std::setw(10) << startX;
+            out << "  masked X = " << std::setw(10) << (endX % Slope::kOne) << "  lastX = " << std::setw(10) << (startX % Slope::kOne);
+            out << "  inc = " << std::setw(10) << slope.DX();
+            out << "\n";
             // clang-format on
         }
-    }
+    });
 }
 
-void testSlopes(Data &data, i32 x0, i32 y0, const char *name) {
-    std::cout << "Testing " << name << " slopes... ";
+// Tests every slope of the given datasets in parallel.
+//
+// Each row of slopes of each dataset is tested as an independent task that writes its report into its own buffer.
+// The reports are printed in order once all tasks finish, so the output does not depend on thread scheduling.
+template <typename TData>
+void test(const std::vector<const TData *> &datasets) {
+    constexpr size_t kRows = 192 + 1;
 
-    bool mismatch = false;
-    for (i32 y1 = 0; y1 <= 192; y1++) {
+    struct RowResult {
+        std::ostringstream out;
+        bool mismatch = false;
+    };
+    std::vector<RowResult> results(datasets.size() * kRows);
+
+    ParallelFor(results.size(), [&](size_t index) {
+        NDS_INTERP_TRACE_SCOPE("Test row");
+        const TData &data = *datasets[index / kRows];
+        const Origin origin = getOrigin(data.type);
+        const i32 y1 = (i32)(index % kRows);
+        RowResult &result = results[index];
         for (i32 x1 = 0; x1 <= 256; x1++) {
-            testSlope(data, x1, y1, x0, y0, x1, y1, mismatch);
+            testSlope(data, x1, y1, origin.x, origin.y, x1, y1, result.out, result.mismatch);
+        }
+    });
+
+    for (size_t i = 0; i < datasets.size(); i++) {
+        std::cout << "Testing " << getOrigin(datasets[i]->type).name << " slopes... ";
+
+        bool mismatch = false;
+        for (size_t row = 0; row < kRows; row++) {
+            RowResult &result = results[i * kRows + row];
+            if (result.mismatch && !mismatch) {
+                mismatch = true;
+                std::cout << "found mismatch\n";
+            }
+            std::cout << result.out.str();
+        }
+        if (!mismatch) {
+            std::cout << "OK!\n";
         }
     }
-    if (!mismatch) {
-        std::cout << "OK!\n";
+}
+
+// Validates a data file while it is being received, without loading it into memory.
+//
+// Bytes are pushed into the validator in chunks of any size as they arrive. The validator parses the file with the
+// same rules as forEachRecord, buffering only the record being received, and tests each slope as soon as its record is
+// complete. The first record may be repeated, with the last copy taking precedence as in the other loaders, so a
+// record is only tested once the next record starts with different coordinates or the file ends. Slopes not present
+// in the file are tested as missing in the same order as test(), producing the same report.
+class StreamValidator {
+public:
+    // Parses and validates the next chunk of the file. Returns false once the file is found to be malformed, after
+    // which further chunks are ignored.
+    bool Feed(const u8 *data, size_t size) {
+        while (size > 0 && m_state != State::Done && m_state != State::Failed) {
+            const size_t count = std::min(size, m_needed - m_buffer.size());
+            m_buffer.insert(m_buffer.end(), data, data + count);
+            data += count;
+            size -= count;
+            if (m_buffer.size() == m_needed) {
+                Process();
+                m_buffer.clear();
+            }
+        }
+        return m_state != State::Failed;
     }
+
+    // Validates the remaining slopes once the whole file has been fed. Returns false if the file was truncated or
+    // malformed; the slopes received up to that point are still validated.
+    bool Finish() {
+        if (m_state == State::Header) {
+            std::cout << " -- Invalid file\n";
+            return false;
+        }
+
+        FlushPending();
+        const bool complete = (m_state == State::Done);
+        if (m_state != State::Failed) {
+            if (complete) {
+                // Test every slope past the end of the file as missing
+                TestUpTo(kNumSlopes);
+            } else {
+                std::cout << " -- Truncated file after " << m_nextSlope << " slopes\n";
+            }
+        }
+        if (m_state != State::Failed && !m_mismatch) {
+            std::cout << (complete ? "OK!\n" : "no mismatches so far\n");
+        }
+        return complete;
+    }
+
+private:
+    static constexpr int kNumSlopes = MappedData::kSlopesX * MappedData::kSlopesY;
+
+    enum class State { Header, Coordinates, Spans, Done, Failed };
+
+    // The spans of a single slope record
+    struct Record {
+        int slopeX = 0, slopeY = 0;
+        int firstLine = 0;
+        int count = 0;
+        std::array<u8, 192 * 3> spans;
+
+        Span GetSpan(int x, int y, int line) const {
+            const int index = line - firstLine;
+            if (x != slopeX || y != slopeY || index < 0 || index >= count) {
+                return {false, 0, 0};
+            }
+            const u8 *span = &spans[index * 3];
+            return {span[0] != 0, span[1], span[2]};
+        }
+    };
+
+    // Handles a complete piece of the file stored in m_buffer, which is m_needed bytes long
+    void Process() {
+        switch (m_state) {
+        case State::Header:
+            if (!readHeader(m_buffer.data(), m_buffer.size(), m_header)) {
+                m_state = State::Failed;
+                return;
+            }
+            std::cout << "\nTesting " << getOrigin(m_header.type).name << " slopes... ";
+            m_x = m_header.minX;
+            m_y = m_header.minY;
+            ExpectRecord(true);
+            break;
+        case State::Coordinates:
+            if (m_buffer[0] != (u8)m_prevX || m_buffer[1] != (u8)m_prevY) {
+                std::cout << " -- Invalid file\n";
+                m_state = State::Failed;
+                return;
+            }
+            m_state = State::Spans;
+            m_needed = (size_t)(m_endY - m_startY + 1) * 3;
+            break;
+        case State::Spans:
+            OnRecord();
+            if (m_y > m_header.maxY) {
+                m_state = State::Done;
+            } else {
+                // Advance to the next record; the last one has no coordinates
+                m_prevX = m_x;
+                m_prevY = m_y;
+                if (++m_x > m_header.maxX) {
+                    m_x = m_header.minX;
+                    m_y++;
+                }
+                ExpectRecord(m_y <= m_header.maxY);
+            }
+            break;
+        default: break;
+        }
+    }
+
+    // Prepares to receive the record of slope (prevX, prevY), with or without coordinates
+    void ExpectRecord(bool hasCoordinates) {
+        m_startY = std::min((m_header.type & 2) ? m_prevY : 0, 191);
+        m_endY = std::min((m_header.type & 2) ? 191 : m_prevY, 191);
+        if (hasCoordinates) {
+            m_state = State::Coordinates;
+            m_needed = 2;
+        } else {
+            m_state = State::Spans;
+            m_needed = (size_t)(m_endY - m_startY + 1) * 3;
+        }
+    }
+
+    // Holds the record just received until it is known whether the next record replaces it
+    void OnRecord() {
+        if (m_hasPending && (m_pending.slopeX != m_prevX || m_pending.slopeY != m_prevY)) {
+            FlushPending();
+        }
+        m_pending.slopeX = m_prevX;
+        m_pending.slopeY = m_prevY;
+        m_pending.firstLine = m_startY;
+        m_pending.count = m_endY - m_startY + 1;
+        std::copy(m_buffer.begin(), m_buffer.end(), m_pending.spans.begin());
+        m_hasPending = true;
+    }
+
+    // Tests the pending record along with every missing slope before it
+    void FlushPending() {
+        if (!m_hasPending) {
+            return;
+        }
+        m_hasPending = false;
+        const int index = m_pending.slopeY * MappedData::kSlopesX + m_pending.slopeX;
+        if (index < m_nextSlope) {
+            return;
+        }
+        TestUpTo(index);
+        TestSlope(m_pending);
+        m_nextSlope = index + 1;
+    }
+
+    // Tests all slopes from the next untested slope up to, but not including, the specified slope as missing
+    void TestUpTo(int index) {
+        for (; m_nextSlope < index; m_nextSlope++) {
+            Record missing{};
+            missing.slopeX = m_nextSlope % MappedData::kSlopesX;
+            missing.slopeY = m_nextSlope / MappedData::kSlopesX;
+            TestSlope(missing);
+        }
+    }
+
+    void TestSlope(const Record &record) {
+        const Origin origin = getOrigin(m_header.type);
+        const int x1 = record.slopeX;
+        const int y1 = record.slopeY;
+        std::ostringstream out;
+        bool mismatch = false;
+        testSlope(record, x1, y1, origin.x, origin.y, x1, y1, out, mismatch);
+        if (mismatch && !m_mismatch) {
+            m_mismatch = true;
+            std::cout << "found mismatch\n";
+        }
+        std::cout << out.str();
+    }
+
+    State m_state = State::Header;
+    std::vector<u8> m_buffer;                // Bytes of the piece being received
+    size_t m_needed = DataHeader::kSize;     // Size of the piece being received
+    DataHeader m_header{};                   // Header of the file
+    int m_x = 0, m_y = 0;                    // Loop position of the parser (see forEachRecord)
+    int m_prevX = 0, m_prevY = 0;            // Slope of the record being received
+    int m_startY = 0, m_endY = 0;            // Scanlines of the record being received
+    Record m_pending;                        // Last record received, not yet tested
+    bool m_hasPending = false;               // Whether m_pending holds a record
+    int m_nextSlope = 0;                     // Index of the next slope to be tested
+    bool m_mismatch = false;                 // Whether any slope mismatched
+};
+
+// Validates a data file while streaming it from disk in small chunks. Compressed files are much smaller than the
+// chunks of the raw file, so they are read at once and decompressed to the validator one row of slopes at a time.
+bool streamFile(std::filesystem::path path) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        std::cout << path.string() << " could not be opened.\n";
+        return false;
+    }
+
+    std::cout << "Streaming " << path.string() << "... ";
+    StreamValidator validator;
+    std::array<char, 16384> chunk;
+    in.read(chunk.data(), chunk.size());
+    if (CaptureCodec::IsCompressed((const u8 *)chunk.data(), (size_t)in.gcount())) {
+        std::vector<u8> compressed(chunk.begin(), chunk.begin() + in.gcount());
+        while (in) {
+            in.read(chunk.data(), chunk.size());
+            compressed.insert(compressed.end(), chunk.begin(), chunk.begin() + in.gcount());
+        }
+        // The validator reports malformed contents itself when it rejects a piece
+        bool accepted = true;
+        const bool decoded = CaptureCodec::DecompressRows(
+            compressed.data(), compressed.size(),
+            [&](const u8 *bytes, size_t size) { return accepted = validator.Feed(bytes, size); });
+        if (!decoded && accepted) {
+            std::cout << "invalid compressed file\n";
+            return false;
+        }
+        return validator.Finish();
+    }
+
+    while (validator.Feed((const u8 *)chunk.data(), (size_t)in.gcount()) && in) {
+        in.read(chunk.data(), chunk.size());
+    }
+    return validator.Finish();
 }
 
-void test(Data &data) {
-    switch (data.type) {
-    case 0: testSlopes(data, 0, 0, "top left"); break;
-    case 1: testSlopes(data, 256, 0, "top right"); break;
-    case 2: testSlopes(data, 0, 192, "bottom left"); break;
-    case 3: testSlopes(data, 256, 192, "bottom right"); break;
+// Rolling hash of the spans of a row of slopes, built on the accumulator round and final mix of xxHash64
+class SpanHash {
+public:
+    void Add(u32 value) {
+        m_state += value * kPrime2;
+        m_state = ((m_state << 31) | (m_state >> 33)) * kPrime1;
     }
+
+    u64 Value() const {
+        u64 hash = m_state;
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+private:
+    static constexpr u64 kPrime1 = 0x9E3779B185EBCA87ull;
+    static constexpr u64 kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr u64 kPrime3 = 0x165667B19E3779F9ull;
+
+    u64 m_state = kPrime1;
+};
+
+// Span of a tested scanline as hashed into the golden manifest. Unlike Span, the coordinates are not truncated, so
+// spans generated out of the captured range never hash like a captured span.
+struct HashedSpan {
+    bool exists;
+    i32 start, end;
+};
+
+// Number of rows of slopes in each dataset, one per Y coordinate of the slope's endpoint
+constexpr i32 kGoldenRows = 192 + 1;
+
+// Computes the golden hash of a row of slopes, with the same scanlines compared by testSlope. getSpan(slopeX, y,
+// startScrX, endScrX) returns the span to hash for each scanline, either generated by Slope or read from a capture.
+template <typename Fn>
+u64 hashRow(u8 type, i32 row, Fn &&getSpan) {
+    const Origin origin = getOrigin(type);
+    SpanHash hash;
+    for (i32 x1 = 0; x1 <= 256; x1++) {
+        hash.Add((u32)x1);
+        forEachTestedSpan(origin.x, origin.y, x1, row, [&](const Slope &, i32 y, i32 startScrX, i32 endScrX) {
+            const HashedSpan span = getSpan(x1, y, startScrX, endScrX);
+            hash.Add((u32)y);
+            hash.Add(span.exists ? (u32)span.start : ~0u);
+            hash.Add(span.exists ? (u32)span.end : ~0u);
+        });
+    }
+    return hash.Value();
+}
+
+// Writes the golden manifest with the hash of every row of slopes captured in the given datasets
+template <typename TData>
+bool writeGolden(const std::vector<const TData *> &datasets, std::filesystem::path path) {
+    std::vector<u64> hashes(datasets.size() * kGoldenRows);
+    ParallelFor(hashes.size(), [&](size_t index) {
+        const TData &data = *datasets[index / kGoldenRows];
+        const i32 row = (i32)(index % kGoldenRows);
+        hashes[index] = hashRow(data.type, row, [&](i32 slopeX, i32 y, i32, i32) {
+            const Span span = data.GetSpan(slopeX, row, y);
+            return HashedSpan{span.exists, span.start, span.end};
+        });
+    });
+
+    std::ofstream out{path, std::ios::trunc};
+    if (!out) {
+        std::cout << path.string() << " could not be created.\n";
+        return false;
+    }
+    out << "# Golden hashes of the spans captured for each row of slopes of each dataset, written by --write-golden\n";
+    out << "# dataset row hash\n";
+    for (size_t i = 0; i < hashes.size(); i++) {
+        out << getOrigin(datasets[i / kGoldenRows]->type).shortName << " " << (i % kGoldenRows) << " " << std::hex
+            << std::setw(16) << std::setfill('0') << hashes[i] << std::dec << std::setfill(' ') << "\n";
+    }
+    std::cout << "Wrote " << hashes.size() << " golden hashes to " << path.string() << "\n";
+    return true;
 }
 
-int main() {
+// Verifies the spans generated by Slope against the golden manifest, without reading the captures.
+//
+// The hashes of every row of slopes are computed in parallel and compared against the manifest. Rows that do not
+// match are tested against the capture of their dataset in dataDir, if present, to report the mismatching spans.
+bool checkGolden(std::filesystem::path path, std::filesystem::path dataDir) {
+    std::ifstream in{path};
+    if (!in) {
+        std::cout << path.string() << " could not be opened.\n";
+        return false;
+    }
+
+    // Golden hashes of each row of each dataset type
+    std::vector<u64> golden(4 * kGoldenRows);
+    std::vector<u8> present(golden.size(), false);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields{line};
+        std::string name;
+        i32 row;
+        u64 hash;
+        fields >> name >> row >> std::hex >> hash;
+        u8 type = 0;
+        while (type < 4 && name != getOrigin(type).shortName) {
+            type++;
+        }
+        if (!fields || type == 4 || row < 0 || row >= kGoldenRows) {
+            std::cout << path.string() << ": invalid line \"" << line << "\"\n";
+            return false;
+        }
+        golden[type * kGoldenRows + row] = hash;
+        present[type * kGoldenRows + row] = true;
+    }
+
+    std::vector<u8> matches(golden.size(), false);
+    ParallelFor(golden.size(), [&](size_t index) {
+        if (!present[index]) return;
+        const u8 type = (u8)(index / kGoldenRows);
+        const u64 hash = hashRow(type, (i32)(index % kGoldenRows), [](i32, i32, i32 start, i32 end) {
+            return HashedSpan{true, start, end};
+        });
+        matches[index] = (hash == golden[index]);
+    });
+
+    bool ok = true;
+    for (u8 type = 0; type < 4; type++) {
+        const Origin origin = getOrigin(type);
+        std::vector<i32> mismatches;
+        for (i32 row = 0; row < kGoldenRows; row++) {
+            if (!matches[type * kGoldenRows + row]) {
+                mismatches.push_back(row);
+            }
+        }
+        std::cout << "Checking " << origin.name << " slopes against golden hashes... ";
+        if (mismatches.empty()) {
+            std::cout << "OK!\n";
+            continue;
+        }
+        ok = false;
+        std::cout << "found " << mismatches.size() << " mismatching rows\n";
+
+        // Fall back to the capture to find the spans that differ
+        const std::filesystem::path dataPath = dataDir / (std::string(origin.shortName) + ".bin");
+        auto pData = std::filesystem::exists(dataPath) ? mapFile(dataPath) : nullptr;
+        for (i32 row : mismatches) {
+            if (!present[type * kGoldenRows + row]) {
+                std::cout << "Row " << std::setw(3) << row << ": no golden hash\n";
+            } else if (!pData) {
+                std::cout << "Row " << std::setw(3) << row << ": hash mismatch, capture not available\n";
+            } else {
+                bool mismatch = false;
+                for (i32 x1 = 0; x1 <= 256; x1++) {
+                    testSlope(*pData, x1, row, origin.x, origin.y, x1, row, std::cout, mismatch);
+                }
+                if (!mismatch) {
+                    std::cout << "Row " << std::setw(3) << row << ": matches the capture, golden hash is out of date\n";
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+// Runs the differential fuzzer with the arguments following --fuzz or --fuzz-exhaustive. The span lookup table is
+// checked as well if a path is given, generating the table first if the file does not exist, or if data/spans.lut
+// exists otherwise.
+bool fuzzFromArgs(bool exhaustive, int argc, char *argv[]) {
+    auto arg = [&](int index, u64 defaultValue) { return (index < argc) ? std::stoull(argv[index]) : defaultValue; };
+
+    SpanLUT lut;
+    const bool hasPath = argc > 4;
+    const std::filesystem::path lutPath = hasPath ? argv[4] : "data/spans.lut";
+    if (hasPath && !std::filesystem::exists(lutPath)) {
+        std::cout << "Generating " << lutPath.string() << "...\n";
+        if (!SpanLUT::Generate(lutPath)) {
+            std::cout << "Could not write " << lutPath.string() << "\n";
+            return false;
+        }
+    }
+    const bool hasLUT = std::filesystem::exists(lutPath) && lut.Open(lutPath);
+    if (hasPath && !hasLUT) {
+        std::cout << lutPath.string() << " is not a valid span lookup table\n";
+        return false;
+    }
+    if (!hasLUT) {
+        std::cout << "Not checking SpanLUT; pass a table path to check it\n";
+    }
+
+    if (exhaustive) {
+        // --fuzz-exhaustive [first edge] [edge count] [span table]
+        return fuzzExhaustive(arg(2, 0), arg(3, kFuzzExhaustiveEdges), hasLUT ? &lut : nullptr);
+    }
+    // --fuzz [edge count] [seed] [span table]
+    return fuzzRandom(arg(3, 1), arg(2, 100'000'000), hasLUT ? &lut : nullptr);
+}
+
+// Prints the totals of the instrumentation counters with the share of each kind of slope
+void printInstrumentTotals() {
+    const auto totals = InstrumentTotals();
+    const u64 setups = totals[(size_t)InstrumentCounter::Setups];
+    std::cout << "Instrumentation counters:\n";
+    for (size_t i = 0; i < kInstrumentCounterCount; i++) {
+        std::cout << "  " << std::setw(20) << std::left << InstrumentCounterName((InstrumentCounter)i) << std::right
+                  << std::setw(14) << totals[i];
+        const bool perSetup = i == (size_t)InstrumentCounter::XMajorEdges ||
+                              i == (size_t)InstrumentCounter::YMajorEdges ||
+                              i == (size_t)InstrumentCounter::NegativeSlopes;
+        if (perSetup && setups > 0) {
+            std::cout << "  (" << std::fixed << std::setprecision(1) << (100.0 * totals[i] / setups) << "%)";
+        }
+        std::cout << "\n";
+    }
+}
+
+// Prints the command line options
+void printUsage(const char *program) {
+    std::cout << "Usage: " << program << " [option]\n"
+              << "With no option, the captures in the data folder are loaded and every slope is tested against them.\n"
+              << "  --golden                     Verify the slopes against data/golden.txt\n"
+              << "  --write-golden               Test the captures and regenerate data/golden.txt from them\n"
+              << "  --fuzz [count] [seed] [lut]  Check every interpolation backend on random edges, and the span\n"
+              << "                               lookup table at <lut> (generated if missing) or data/spans.lut\n"
+              << "  --fuzz-exhaustive [first] [count] [lut]\n"
+              << "                               Check every interpolation backend on a range of all edges\n"
+              << "  --bench                      Run the slope setup and span generation microbenchmarks\n"
+              << "  --generate-lut [path]        Write the span lookup table (default data/spans.lut)\n"
+              << "  --compress <raw> [out]       Compress a capture (default output <raw>.ndsc)\n"
+              << "  --stream [files...]          Validate captures while streaming them (default data/*.bin)\n"
+              << "  --write-images <dir>         Render every captured slope into TGA files in <dir>/TL, TR, BL, BR\n"
+              << "  --write-archive <dir>        Pack the renderings into <dir>/TL.tar, TR.tar, BL.tar, BR.tar\n"
+              << "  --help                       Print this message\n";
+}
+
+int main(int argc, char *argv[]) {
+    const char *command = (argc > 1) ? argv[1] : "";
+    auto isCommand = [&](const char *name) { return std::strcmp(command, name) == 0; };
+
+    if (isCommand("--help")) {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    // Check every interpolation backend against the reference implementation
+    if (isCommand("--fuzz") || isCommand("--fuzz-exhaustive")) {
+        return fuzzFromArgs(isCommand("--fuzz-exhaustive"), argc, argv) ? 0 : 1;
+    }
+
+    // Verify the slopes against the golden manifest only, falling back to the captures for mismatching rows
+    if (isCommand("--golden")) {
+        return checkGolden("data/golden.txt", "data") ? 0 : 1;
+    }
+
+    if (isCommand("--bench")) {
+        runBenchmarks();
+        return 0;
+    }
+
+    if (isCommand("--generate-lut")) {
+        return SpanLUT::Generate((argc > 2) ? argv[2] : "data/spans.lut") ? 0 : 1;
+    }
+
+    if (isCommand("--compress")) {
+        if (argc < 3) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        const std::filesystem::path rawPath = argv[2];
+        const std::filesystem::path compressedPath =
+            (argc > 3) ? std::filesystem::path{argv[3]} : std::filesystem::path{rawPath}.replace_extension(".ndsc");
+        return compressFile(rawPath, compressedPath) ? 0 : 1;
+    }
+
+    // Validate the captures while streaming them from disk instead of loading them first
+    if (isCommand("--stream")) {
+        bool ok = true;
+        if (argc > 2) {
+            for (int i = 2; i < argc; i++) {
+                ok &= streamFile(argv[i]);
+            }
+        } else {
+            for (auto path : {"data/TL.bin", "data/TR.bin", "data/BL.bin", "data/BR.bin"}) {
+                ok &= streamFile(path);
+            }
+        }
+        return ok ? 0 : 1;
+    }
+
+    const bool writeImageFiles = isCommand("--write-images");
+    const bool writeImageArchives = isCommand("--write-archive");
+    if ((writeImageFiles || writeImageArchives) && argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (argc > 1 && !writeImageFiles && !writeImageArchives && !isCommand("--write-golden")) {
+        std::cout << "Unknown option " << command << "\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+
     // convertScreenCap("data/screencap.bin", "data/screencap.tga");
     // uniqueColors("data/screencap.bin");
 
-    auto dataTL = readFile("data/TL.bin");
-    auto dataTR = readFile("data/TR.bin");
-    auto dataBL = readFile("data/BL.bin");
-    auto dataBR = readFile("data/BR.bin");
+    constexpr std::array<const char *, 4> kNames = {"TL", "TR", "BL", "BR"};
+    std::array<std::unique_ptr<MappedData>, 4> data;
+    std::vector<const MappedData *> datasets;
+    for (size_t i = 0; i < kNames.size(); i++) {
+        data[i] = mapFile(std::string{"data/"} + kNames[i] + ".bin");
+        if (data[i]) datasets.push_back(data[i].get());
+    }
+
+    // Render the captures instead of testing them
+    if (writeImageFiles || writeImageArchives) {
+        const std::filesystem::path outDir = argv[2];
+        std::filesystem::create_directories(outDir);
+        bool ok = true;
+        for (size_t i = 0; i < kNames.size(); i++) {
+            if (!data[i]) {
+                continue;
+            }
+            if (writeImageFiles) {
+                writeImages(*data[i], outDir / kNames[i]);
+            } else {
+                ok &= writeImageArchive(*data[i], outDir / (std::string{kNames[i]} + ".tar"));
+            }
+        }
+        return ok ? 0 : 1;
+    }
 
-    if (dataTL) test(*dataTL);
-    if (dataTR) test(*dataTR);
-    if (dataBL) test(*dataBL);
-    if (dataBR) test(*dataBR);
+    test(datasets);
 
-    // if (dataTL) writeImages(*dataTL, "C:/temp/TL");
-    // if (dataTR) writeImages(*dataTR, "C:/temp/TR");
-    // if (dataBL) writeImages(*dataBL, "C:/temp/BL");
-    // if (dataBR) writeImages(*dataBR, "C:/temp/BR");
+    // Regenerate the golden manifest from the captures
+    if (isCommand("--write-golden")) {
+        writeGolden(datasets, "data/golden.txt");
+    }
+
+    // Export the counters and trace of the test run in instrumented builds
+    if constexpr (kInstrumentEnabled) {
+        printInstrumentTotals();
+        for (auto [path, write] : {std::pair{"instrument.json", &WriteInstrumentJSON},
+                                   std::pair{"instrument_trace.json", &WriteInstrumentTrace}}) {
+            std::cout << (write(path) ? "Written to " : "Could not write ") << path << "\n";
+        }
+    }
 
     return 0;
 }
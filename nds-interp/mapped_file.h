@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/// <summary>
+/// A read-only memory-mapped file.
+/// </summary>
+/// <remarks>
+/// The mapping is shared with every other process that maps the same file, and pages are loaded on demand by the
+/// operating system, so opening even large files costs virtually nothing.
+/// </remarks>
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /// <summary>
+    /// Maps the specified file into memory, closing the previously mapped file if there is one.
+    /// </summary>
+    /// <param name="path">The path to the file to map</param>
+    /// <returns>true if the file was mapped successfully.</returns>
+    bool Open(const std::filesystem::path &path);
+
+    /// <summary>
+    /// Unmaps the file.
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Determines if a file is currently mapped.
+    /// </summary>
+    /// <returns>true if a file is mapped.</returns>
+    bool IsOpen() const { return m_data != nullptr; }
+
+    /// <summary>
+    /// Retrieves a pointer to the mapped contents of the file.
+    /// </summary>
+    /// <returns>A pointer to the first byte of the file, or nullptr if no file is mapped</returns>
+    const uint8_t *Data() const { return m_data; }
+
+    /// <summary>
+    /// Retrieves the size of the mapped file.
+    /// </summary>
+    /// <returns>The size of the file in bytes</returns>
+    size_t Size() const { return m_size; }
+
+private:
+    const uint8_t *m_data = nullptr; // Mapped contents of the file
+    size_t m_size = 0;               // Size of the file in bytes
+#ifdef _WIN32
+    void *m_file = nullptr;    // File handle
+    void *m_mapping = nullptr; // File mapping handle
+#endif
+};
@@ -0,0 +1,95 @@
+#include "nds_slope.h"
+
+#include <algorithm>
+#include <array>
+
+#include "rasterizer.h"
+#include "slope.h"
+#include "slope_batch.h"
+#include "slope_simd.h"
+
+static_assert(sizeof(nds_slope) == 16, "nds_slope must keep its layout");
+static_assert(sizeof(nds_span) == sizeof(Rasterizer::Span), "nds_span must match Rasterizer::Span");
+static_assert(sizeof(nds_vertex) == sizeof(Rasterizer::Vertex), "nds_vertex must match Rasterizer::Vertex");
+
+namespace {
+
+// The number of slopes configured at once by nds_slope_setup_batch
+constexpr size_t kBatchSize = 256;
+
+Slope ToSlope(const nds_slope &slope) {
+    return Slope::FromParameters(slope.x0, slope.y0, slope.dx, slope.negative != 0, slope.x_major != 0);
+}
+
+nds_slope FromSlope(const Slope &slope) {
+    return {slope.X0(), slope.Y0(), slope.DX(), (uint8_t)slope.IsNegative(), (uint8_t)slope.IsXMajor(), {0, 0}};
+}
+
+} // namespace
+
+uint32_t nds_slope_api_version(void) {
+    return NDS_SLOPE_API_VERSION;
+}
+
+void nds_slope_setup(nds_slope *slope, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    Slope result;
+    result.Setup(x0, y0, x1, y1);
+    *slope = FromSlope(result);
+}
+
+nds_visible_range nds_slope_setup_clipped(nds_slope *slope, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                                          const nds_clip_rect *clip) {
+    Slope result;
+    const Slope::VisibleRange range =
+        result.Setup(x0, y0, x1, y1, {clip->left, clip->top, clip->right, clip->bottom});
+    *slope = FromSlope(result);
+    return {range.y0, range.y1, range.xMin, range.xMax};
+}
+
+void nds_slope_setup_batch(nds_slope *slopes, const int32_t *x0, const int32_t *y0, const int32_t *x1,
+                           const int32_t *y1, size_t count) {
+    SlopeBatch<kBatchSize> batch;
+    for (size_t first = 0; first < count; first += kBatchSize) {
+        const size_t size = std::min(kBatchSize, count - first);
+        batch.Setup(&x0[first], &y0[first], &x1[first], &y1[first], size);
+        for (size_t i = 0; i < size; i++) {
+            slopes[first + i] = {batch.X0()[i], batch.Y0()[i], batch.DX()[i], batch.Negative()[i],
+                                 batch.XMajor()[i], {0, 0}};
+        }
+    }
+}
+
+int32_t nds_slope_x_start(const nds_slope *slope, int32_t y) {
+    return ToSlope(*slope).XStart(y);
+}
+
+int32_t nds_slope_x_end(const nds_slope *slope, int32_t y) {
+    return ToSlope(*slope).XEnd(y);
+}
+
+void nds_slope_spans(const nds_slope *slope, int32_t y0, int32_t y1, int32_t *starts, int32_t *ends) {
+    GenerateSpansSIMD(ToSlope(*slope), y0, y1, starts, ends);
+}
+
+size_t nds_rasterize_polygon(const nds_vertex *vertices, size_t count, int32_t y0, int32_t y1, nds_span *spans,
+                             size_t capacity) {
+    std::array<Rasterizer::Vertex, Rasterizer::kMaxVertices> polygon;
+    if (count > polygon.size()) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        polygon[i] = {vertices[i].x, vertices[i].y};
+    }
+
+    Rasterizer rasterizer;
+    if (!rasterizer.Setup(polygon.data(), count)) {
+        return 0;
+    }
+    std::array<Rasterizer::Span, Rasterizer::kScreenHeight> result;
+    const size_t numSpans = rasterizer.Rasterize(y0, y1, result.data(), std::min(capacity, result.size()));
+    for (size_t i = 0; i < numSpans; i++) {
+        const Rasterizer::Span &span = result[i];
+        spans[i] = {span.y, span.xStart, span.xEnd, span.leftEdgeEnd, span.rightEdgeStart};
+    }
+    return numSpans;
+}
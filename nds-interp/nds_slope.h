@@ -0,0 +1,153 @@
+#ifndef NDS_SLOPE_H
+#define NDS_SLOPE_H
+
+// C interface to the slope interpolator and polygon rasterizer, for embedding into emulators and other programs that
+// cannot use the C++ headers directly. Every structure is plain data with a fixed layout and every function has C
+// linkage, so the interface remains compatible across versions with the same NDS_SLOPE_API_VERSION. Build the
+// nds_slope library with link-time optimization (NDS_INTERP_LTO in CMake) to let the calls inline into the caller.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// <summary>
+/// The version of the interface, incremented whenever a structure or function changes incompatibly.
+/// </summary>
+#define NDS_SLOPE_API_VERSION 1
+
+/// <summary>
+/// A configured slope. The fields are those of Slope; see Slope::FromParameters.
+/// </summary>
+typedef struct nds_slope {
+    int32_t x0;          // X0 coordinate with 18 fractional bits, adjusted for bias and negative slopes
+    int32_t y0;          // Y coordinate of the top endpoint
+    int32_t dx;          // X displacement per scanline with 18 fractional bits
+    uint8_t negative;    // 1 if the slope is negative (X1 < X0), 0 otherwise
+    uint8_t x_major;     // 1 if the slope is X-major (X1-X0 > Y1-Y0), 0 otherwise
+    uint8_t reserved[2]; // Always zero
+} nds_slope;
+
+/// <summary>
+/// A clipping rectangle in screen coordinates. The right and bottom edges are exclusive.
+/// </summary>
+typedef struct nds_clip_rect {
+    int32_t left, top, right, bottom;
+} nds_clip_rect;
+
+/// <summary>
+/// The part of a slope that lies within a clipping rectangle. See Slope::VisibleRange.
+/// </summary>
+typedef struct nds_visible_range {
+    int32_t y0;    // Y coordinate of the first visible scanline
+    int32_t y1;    // Y coordinate past the last visible scanline, equal to y0 if no scanline is visible
+    int32_t x_min; // Leftmost visible pixel, clamped to the clipping rectangle
+    int32_t x_max; // Rightmost visible pixel, clamped to the clipping rectangle
+} nds_visible_range;
+
+/// <summary>
+/// A polygon vertex in screen coordinates.
+/// </summary>
+typedef struct nds_vertex {
+    int32_t x, y;
+} nds_vertex;
+
+/// <summary>
+/// The pixels covered by a polygon on one scanline, clipped to the screen. See Rasterizer::Span.
+/// </summary>
+typedef struct nds_span {
+    int32_t y;                // The scanline
+    int32_t x_start;          // The leftmost pixel of the span
+    int32_t x_end;            // The rightmost pixel of the span
+    int32_t left_edge_end;    // The rightmost pixel covered by the left edge
+    int32_t right_edge_start; // The leftmost pixel covered by the right edge
+} nds_span;
+
+/// <summary>
+/// Retrieves the version of the interface implemented by the library, which must match NDS_SLOPE_API_VERSION.
+/// </summary>
+/// <returns>The version of the interface</returns>
+uint32_t nds_slope_api_version(void);
+
+/// <summary>
+/// Configures a slope to interpolate the line (X0,Y0)-(X1,Y1) using screen coordinates. See Slope::Setup.
+/// </summary>
+/// <param name="slope">The slope to configure</param>
+/// <param name="x0">First X coordinate</param>
+/// <param name="y0">First Y coordinate</param>
+/// <param name="x1">Second X coordinate</param>
+/// <param name="y1">Second Y coordinate</param>
+void nds_slope_setup(nds_slope *slope, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+
+/// <summary>
+/// Configures a slope and computes the part of it that lies within a clipping rectangle.
+/// </summary>
+/// <param name="slope">The slope to configure</param>
+/// <param name="x0">First X coordinate</param>
+/// <param name="y0">First Y coordinate</param>
+/// <param name="x1">Second X coordinate</param>
+/// <param name="y1">Second Y coordinate</param>
+/// <param name="clip">The clipping rectangle</param>
+/// <returns>The visible scanlines and X range of the slope</returns>
+nds_visible_range nds_slope_setup_clipped(nds_slope *slope, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                                          const nds_clip_rect *clip);
+
+/// <summary>
+/// Configures the slopes of the lines (X0[i],Y0[i])-(X1[i],Y1[i]) with the vectorizable batch setup of SlopeBatch.
+/// </summary>
+/// <param name="slopes">The array that receives the slopes</param>
+/// <param name="x0">First X coordinates</param>
+/// <param name="y0">First Y coordinates</param>
+/// <param name="x1">Second X coordinates</param>
+/// <param name="y1">Second Y coordinates</param>
+/// <param name="count">The number of slopes to configure</param>
+void nds_slope_setup_batch(nds_slope *slopes, const int32_t *x0, const int32_t *y0, const int32_t *x1,
+                           const int32_t *y1, size_t count);
+
+/// <summary>
+/// Computes the starting X screen coordinate of the span of a scanline. See Slope::XStart.
+/// </summary>
+/// <param name="slope">The slope</param>
+/// <param name="y">The Y coordinate of the scanline</param>
+/// <returns>The starting X coordinate, which is the rightmost pixel of the span on negative slopes</returns>
+int32_t nds_slope_x_start(const nds_slope *slope, int32_t y);
+
+/// <summary>
+/// Computes the ending X screen coordinate of the span of a scanline. See Slope::XEnd.
+/// </summary>
+/// <param name="slope">The slope</param>
+/// <param name="y">The Y coordinate of the scanline</param>
+/// <returns>The ending X coordinate, which is the leftmost pixel of the span on negative slopes</returns>
+int32_t nds_slope_x_end(const nds_slope *slope, int32_t y);
+
+/// <summary>
+/// Computes the spans of a range of scanlines. Ranges of at least 32 scanlines use the fastest SIMD kernel supported by
+/// the CPU, while shorter ranges use the scalar code, which is faster for them. See GenerateSpansSIMD.
+/// </summary>
+/// <param name="slope">The slope</param>
+/// <param name="y0">The Y coordinate of the first scanline</param>
+/// <param name="y1">The Y coordinate past the last scanline</param>
+/// <param name="starts">The array that receives Y1-Y0 starting X screen coordinates</param>
+/// <param name="ends">The array that receives Y1-Y0 ending X screen coordinates</param>
+void nds_slope_spans(const nds_slope *slope, int32_t y0, int32_t y1, int32_t *starts, int32_t *ends);
+
+/// <summary>
+/// Rasterizes a convex polygon over the visible scanlines within a range. See Rasterizer::Rasterize.
+/// </summary>
+/// <param name="vertices">The vertices of the polygon, in either winding order</param>
+/// <param name="count">The number of vertices, between 3 and 10</param>
+/// <param name="y0">The first scanline of the range</param>
+/// <param name="y1">The scanline past the last scanline of the range</param>
+/// <param name="spans">The array that receives the spans, from top to bottom</param>
+/// <param name="capacity">The number of elements of the array; 192 covers the whole screen</param>
+/// <returns>The number of spans written, or 0 if the number of vertices is not supported</returns>
+size_t nds_rasterize_polygon(const nds_vertex *vertices, size_t count, int32_t y0, int32_t y1, nds_span *spans,
+                             size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NDS_SLOPE_H
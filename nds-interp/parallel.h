@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// Determines the number of worker threads used by ParallelFor.
+/// </summary>
+/// <returns>The number of hardware threads, or 1 if it cannot be determined</returns>
+inline size_t WorkerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// <summary>
+/// Invokes fn(i) for every i in [0, count) across all hardware threads.
+/// </summary>
+/// <remarks>
+/// Work items are handed out one at a time from a shared counter, so items of uneven cost are balanced automatically.
+/// The order in which items are processed is unspecified; callers that produce output should store the results of
+/// each item separately and combine them in order once this function returns.
+/// </remarks>
+/// <param name="count">The number of work items</param>
+/// <param name="fn">The function to invoke for each work item</param>
+template <typename Fn>
+void ParallelFor(size_t count, Fn &&fn) {
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            fn(i);
+        }
+    };
+
+    const size_t numThreads = std::min(WorkerCount(), count);
+    if (numThreads <= 1) {
+        worker();
+        return;
+    }
+
+    // The calling thread takes part in the work as well
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for (size_t i = 1; i < numThreads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+/// <summary>
+/// A set of persistent worker threads that run loops like ParallelFor without starting threads on every call.
+/// </summary>
+/// <remarks>
+/// The threads are started by the constructor and joined by the destructor. Run hands out work items exactly like
+/// ParallelFor and allocates no memory, so that the pool can be reused every frame. Calls to Run from multiple threads
+/// are serialized. The function passed to Run must not call Run on the same pool.
+/// </remarks>
+class WorkerPool {
+public:
+    /// <summary>
+    /// Starts the worker threads.
+    /// </summary>
+    /// <param name="numThreads">The number of threads that process work items, including the thread calling Run</param>
+    explicit WorkerPool(size_t numThreads = WorkerCount()) {
+        m_threads.reserve((numThreads > 1) ? numThreads - 1 : 0);
+        for (size_t i = 1; i < numThreads; i++) {
+            m_threads.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    /// <summary>
+    /// Retrieves the number of threads that process work items.
+    /// </summary>
+    /// <returns>The number of worker threads plus one for the thread calling Run</returns>
+    size_t Size() const { return m_threads.size() + 1; }
+
+    /// <summary>
+    /// Invokes fn(i) for every i in [0, count) across the threads of the pool. See ParallelFor.
+    /// </summary>
+    /// <param name="count">The number of work items</param>
+    /// <param name="fn">The function to invoke for each work item</param>
+    template <typename Fn>
+    void Run(size_t count, Fn &&fn) {
+        auto invoke = [](void *context, size_t i) { (*static_cast<std::remove_reference_t<Fn> *>(context))(i); };
+        if (m_threads.empty() || count <= 1) {
+            for (size_t i = 0; i < count; i++) {
+                fn(i);
+            }
+            return;
+        }
+
+        std::lock_guard run{m_runMutex};
+        {
+            std::lock_guard lock{m_mutex};
+            m_invoke = invoke;
+            m_context = const_cast<void *>(static_cast<const void *>(&fn));
+            m_count = count;
+            m_next = 0;
+            m_busy = m_threads.size();
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        // The calling thread takes part in the work as well
+        Work();
+        std::unique_lock lock{m_mutex};
+        m_done.wait(lock, [this] { return m_busy == 0; });
+    }
+
+private:
+    void Work() {
+        for (size_t i = m_next++; i < m_count; i = m_next++) {
+            m_invoke(m_context, i);
+        }
+    }
+
+    void WorkerLoop() {
+        size_t generation = 0;
+        for (;;) {
+            {
+                std::unique_lock lock{m_mutex};
+                m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+                if (m_stop) {
+                    return;
+                }
+                generation = m_generation;
+            }
+            Work();
+            std::lock_guard lock{m_mutex};
+            if (--m_busy == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> m_threads; // Worker threads, not including the thread calling Run
+    std::mutex m_runMutex;              // Serializes calls to Run
+    std::mutex m_mutex;                 // Guards the fields below, except for m_next
+    std::condition_variable m_wake;     // Signaled when a loop starts or the pool is destroyed
+    std::condition_variable m_done;     // Signaled when the last worker finishes a loop
+
+    void (*m_invoke)(void *, size_t) = nullptr; // Invokes the function of the current loop
+    void *m_context = nullptr;                  // The function of the current loop
+    size_t m_count = 0;                         // Number of work items of the current loop
+    std::atomic<size_t> m_next{0};              // Next work item to hand out
+    size_t m_busy = 0;                          // Number of workers that have not finished the current loop
+    size_t m_generation = 0;                    // Number of loops started, which wakes the workers
+    bool m_stop = false;                        // Set by the destructor to stop the workers
+};
@@ -0,0 +1,74 @@
+#include "rasterizer.h"
+
+#include <algorithm>
+
+bool Rasterizer::Setup(const Vertex *vertices, size_t count) {
+    if (count < 3 || count > kMaxVertices) {
+        m_count = 0;
+        return false;
+    }
+
+    m_count = count;
+    m_topVertex = 0;
+    m_top = vertices[0].y;
+    m_bottom = vertices[0].y;
+    for (size_t i = 0; i < count; i++) {
+        const Vertex &v0 = vertices[i];
+        const Vertex &v1 = vertices[(i + 1 < count) ? (i + 1) : 0];
+        m_vertices[i] = v0;
+        m_edges[i].Setup(v0.x, v0.y, v1.x, v1.y);
+        if (v0.y < m_top) {
+            m_top = v0.y;
+            m_topVertex = i;
+        }
+        m_bottom = std::max(m_bottom, v0.y);
+    }
+    return true;
+}
+
+size_t Rasterizer::NextVertex(size_t vertex, bool forward) const {
+    if (forward) {
+        return (vertex + 1 < m_count) ? (vertex + 1) : 0;
+    } else {
+        return (vertex > 0) ? (vertex - 1) : (m_count - 1);
+    }
+}
+
+Rasterizer::Chain Rasterizer::StartChain(size_t vertex, bool forward, i32 y) const {
+    // Skip edges that end at or above the scanline, including edges with no height. The bottom vertex is always
+    // below the scanline, so a convex polygon reaches a covering edge within one lap.
+    size_t next = NextVertex(vertex, forward);
+    for (size_t i = 1; i < m_count && m_vertices[next].y <= y; i++) {
+        vertex = next;
+        next = NextVertex(vertex, forward);
+    }
+
+    // Forward chains walk edge i from vertex i to i+1; backward chains walk edge i-1 from vertex i to i-1
+    const size_t edge = forward ? vertex : next;
+    return {vertex, edge, forward, m_edges[edge].IsNegative(), m_vertices[next].y, m_edges[edge].Begin(y)};
+}
+
+size_t Rasterizer::Rasterize(i32 y0, i32 y1, Span *spans, size_t capacity) const {
+    return Walk(y0, y1, capacity, [&](const Span &span, size_t, size_t) { *spans++ = span; });
+}
+
+bool Rasterizer::Rasterize(i32 y0, i32 y1, FrameArena &arena, SpanList &list) const {
+    list = {nullptr, 0};
+    if (m_count == 0) {
+        return true;
+    }
+
+    // Polygons with no height occupy a single scanline
+    const i32 top = std::max({m_top, y0, 0});
+    const i32 bottom = std::min({std::max(m_bottom, m_top + 1), y1, kScreenHeight});
+    if (top >= bottom) {
+        return true;
+    }
+
+    Span *spans = arena.Allocate<Span>(bottom - top);
+    if (spans == nullptr) {
+        return false;
+    }
+    list = {spans, Rasterize(y0, y1, spans, bottom - top)};
+    return true;
+}
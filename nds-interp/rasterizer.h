@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_arena.h"
+#include "instrument.h"
+#include "parallel.h"
+#include "slope.h"
+
+/// <summary>
+/// Rasterizes convex polygons into per-scanline spans using the Nintendo DS's edge interpolation and pairing rules.
+/// </summary>
+/// <remarks>
+/// A polygon is prepared once with Setup, which configures a Slope for every edge. Rasterize then walks the scanlines
+/// from the top vertex downwards along two chains of edges, one in each winding direction, switching to the next edge
+/// of a chain whenever the scanline reaches the chain's next vertex (the middle vertex of a triangle). Edges with no
+/// height are skipped.
+///
+/// On each scanline, the chain whose edge is further to the left becomes the left edge, regardless of the polygon's
+/// winding order. As on hardware, the span covers every pixel from the leftmost pixel of the left edge to the
+/// rightmost pixel of the right edge, including the pixels covered by the edges themselves. Because each edge is
+/// interpolated exactly like Slope does, X-major edges produce the same one-pixel gaps as on hardware.
+///
+/// Scanlines run from the top vertex (inclusive) to the bottom vertex (exclusive), so polygons sharing an edge never
+/// overlap vertically. Polygons with no height are rasterized as a single scanline spanning their leftmost to
+/// rightmost vertices. Spans are clipped to the 256x192 screen.
+///
+/// No memory is allocated: the edges are stored in the rasterizer and the spans are written into a caller-provided
+/// buffer, or into a FrameArena that holds the spans of every polygon of the frame.
+/// </remarks>
+class Rasterizer {
+    using i32 = int32_t;
+
+public:
+    /// <summary>
+    /// The maximum number of vertices of a polygon. Clipping a quad against the view volume produces at most 10.
+    /// </summary>
+    static constexpr size_t kMaxVertices = 10;
+
+    /// <summary>
+    /// The width of the screen in pixels.
+    /// </summary>
+    static constexpr i32 kScreenWidth = 256;
+
+    /// <summary>
+    /// The height of the screen in pixels, which is also the maximum number of spans produced by a polygon.
+    /// </summary>
+    static constexpr i32 kScreenHeight = 192;
+
+    /// <summary>
+    /// A polygon vertex in screen coordinates.
+    /// </summary>
+    struct Vertex {
+        i32 x, y;
+    };
+
+    /// <summary>
+    /// The pixels covered by a polygon on one scanline. All X coordinates are inclusive and clipped to the screen.
+    /// </summary>
+    struct Span {
+        i32 y;              // The scanline
+        i32 xStart;         // The leftmost pixel of the span, which is the leftmost pixel of the left edge
+        i32 xEnd;           // The rightmost pixel of the span, which is the rightmost pixel of the right edge
+        i32 leftEdgeEnd;    // The rightmost pixel covered by the left edge
+        i32 rightEdgeStart; // The leftmost pixel covered by the right edge
+    };
+
+    /// <summary>
+    /// The spans of a polygon stored in a FrameArena.
+    /// </summary>
+    struct SpanList {
+        const Span *spans; // The spans, from top to bottom
+        size_t count;      // The number of spans
+    };
+
+    /// <summary>
+    /// Prepares a convex polygon for rasterization, configuring the slopes of all of its edges.
+    /// </summary>
+    /// <remarks>
+    /// The vertices may be specified in either winding order. Concave or self-intersecting polygons are not supported.
+    /// </remarks>
+    /// <param name="vertices">The vertices of the polygon, in order</param>
+    /// <param name="count">The number of vertices, between 3 and kMaxVertices</param>
+    /// <returns>true if the polygon was prepared, false if the number of vertices is not supported</returns>
+    bool Setup(const Vertex *vertices, size_t count);
+
+    /// <summary>
+    /// Prepares a triangle for rasterization.
+    /// </summary>
+    /// <param name="v0">The first vertex</param>
+    /// <param name="v1">The second vertex</param>
+    /// <param name="v2">The third vertex</param>
+    void SetupTriangle(Vertex v0, Vertex v1, Vertex v2) {
+        const Vertex vertices[] = {v0, v1, v2};
+        Setup(vertices, 3);
+    }
+
+    /// <summary>
+    /// Prepares a convex quad for rasterization.
+    /// </summary>
+    /// <param name="v0">The first vertex</param>
+    /// <param name="v1">The second vertex</param>
+    /// <param name="v2">The third vertex</param>
+    /// <param name="v3">The fourth vertex</param>
+    void SetupQuad(Vertex v0, Vertex v1, Vertex v2, Vertex v3) {
+        const Vertex vertices[] = {v0, v1, v2, v3};
+        Setup(vertices, 4);
+    }
+
+    /// <summary>
+    /// Rasterizes the polygon prepared by Setup, writing the span of every visible scanline from top to bottom.
+    /// </summary>
+    /// <remarks>
+    /// Scanlines where the polygon lies entirely outside the screen produce no span. A buffer of kScreenHeight spans
+    /// is always large enough.
+    /// </remarks>
+    /// <param name="spans">The buffer that receives the spans</param>
+    /// <param name="capacity">The maximum number of spans to write</param>
+    /// <returns>The number of spans written</returns>
+    size_t Rasterize(Span *spans, size_t capacity) const { return Rasterize(0, kScreenHeight, spans, capacity); }
+
+    /// <summary>
+    /// Rasterizes the scanlines of the polygon prepared by Setup within the specified range, from top to bottom.
+    /// </summary>
+    /// <remarks>
+    /// The edges are positioned at the first scanline of the range with random access (Slope::FracXStart), so the
+    /// scanlines above the range are never walked and distinct ranges may be rasterized concurrently from the same
+    /// polygon. The spans are identical to those produced by the full-screen overload for the same scanlines.
+    /// </remarks>
+    /// <param name="y0">The first scanline of the range</param>
+    /// <param name="y1">The scanline past the last scanline of the range</param>
+    /// <param name="spans">The buffer that receives the spans</param>
+    /// <param name="capacity">The maximum number of spans to write</param>
+    /// <returns>The number of spans written</returns>
+    size_t Rasterize(i32 y0, i32 y1, Span *spans, size_t capacity) const;
+
+    /// <summary>
+    /// Rasterizes the polygon prepared by Setup into a frame arena.
+    /// </summary>
+    /// <param name="arena">The arena that stores the spans until it is reset</param>
+    /// <param name="list">Receives the spans of the polygon</param>
+    /// <returns>true if the polygon was rasterized, false if the arena is out of space</returns>
+    bool Rasterize(FrameArena &arena, SpanList &list) const { return Rasterize(0, kScreenHeight, arena, list); }
+
+    /// <summary>
+    /// Rasterizes the scanlines of the polygon prepared by Setup within the specified range into a frame arena.
+    /// </summary>
+    /// <remarks>
+    /// Room is allocated for every scanline of the range covered by the polygon, so the spans of consecutive polygons
+    /// are contiguous unless some of their scanlines lie outside the screen horizontally. Polygons with no visible
+    /// scanline allocate nothing.
+    /// </remarks>
+    /// <param name="y0">The first scanline of the range</param>
+    /// <param name="y1">The scanline past the last scanline of the range</param>
+    /// <param name="arena">The arena that stores the spans until it is reset</param>
+    /// <param name="list">Receives the spans of the polygon</param>
+    /// <returns>true if the polygon was rasterized, false if the arena is out of space</returns>
+    bool Rasterize(i32 y0, i32 y1, FrameArena &arena, SpanList &list) const;
+
+    /// <summary>
+    /// Retrieves the Y coordinate of the polygon's topmost vertex.
+    /// </summary>
+    /// <returns>The first scanline of the polygon, before clipping</returns>
+    i32 Top() const { return m_top; }
+
+    /// <summary>
+    /// Retrieves the Y coordinate of the polygon's bottommost vertex.
+    /// </summary>
+    /// <returns>The scanline past the last scanline of the polygon, before clipping</returns>
+    i32 Bottom() const { return m_bottom; }
+
+protected:
+    /// <summary>
+    /// Walks the edges of the polygon over the visible scanlines within the specified range, from top to bottom.
+    /// </summary>
+    /// <remarks>
+    /// This is the core of Rasterize, exposed to derived rasterizers that compute additional per-scanline data in the
+    /// same pass. fn(span, leftEdge, rightEdge) is invoked for every visible scanline with the clipped span and the
+    /// indices of the edges on each side of the span (edge i starts at vertex i). On polygons with no height, the edges
+    /// are those starting at the leftmost and rightmost vertices.
+    /// </remarks>
+    /// <param name="y0">The first scanline of the range</param>
+    /// <param name="y1">The scanline past the last scanline of the range</param>
+    /// <param name="capacity">The maximum number of scanlines to walk</param>
+    /// <param name="fn">The function invoked for every visible scanline</param>
+    /// <returns>The number of times fn was invoked</returns>
+    template <typename Fn>
+    size_t Walk(i32 y0, i32 y1, size_t capacity, Fn &&fn) const;
+
+private:
+    // One of the two chains of edges walked from the top vertex to the bottom vertex
+    struct Chain {
+        size_t vertex;          // The upper vertex of the current edge
+        size_t edge;            // The current edge
+        bool forward;           // Whether the chain walks the vertices forwards or backwards
+        bool negative;          // Whether the current edge is a negative slope
+        i32 endY;               // The Y coordinate of the lower vertex of the current edge
+        Slope::Stepper stepper; // The stepper of the current edge, positioned at the current scanline
+    };
+
+    // The leftmost and rightmost pixels covered by an edge on a scanline
+    struct Extent {
+        i32 left, right;
+    };
+
+    // Retrieves the index of the vertex following the specified vertex in the specified direction
+    size_t NextVertex(size_t vertex, bool forward) const;
+
+    // Positions a chain at the edge that covers the specified scanline, starting from the specified vertex
+    Chain StartChain(size_t vertex, bool forward, i32 y) const;
+
+    // Computes the pixels covered by the current edge of a chain on the current scanline
+    static Extent ChainExtent(const Chain &chain) {
+        // The starting coordinate is the rightmost pixel of negative slopes
+        const i32 start = chain.stepper.XStart();
+        const i32 end = chain.stepper.XEnd();
+        return chain.negative ? Extent{end, start} : Extent{start, end};
+    }
+
+    static i32 ClampX(i32 x) { return std::clamp(x, 0, kScreenWidth - 1); }
+
+    std::array<Vertex, kMaxVertices> m_vertices;
+    std::array<Slope, kMaxVertices> m_edges; // Edge i connects vertices i and i+1 (wrapping around)
+    size_t m_count = 0;                      // Number of vertices
+    size_t m_topVertex = 0;                  // Index of the topmost vertex
+    i32 m_top = 0;                           // Y coordinate of the topmost vertex
+    i32 m_bottom = 0;                        // Y coordinate of the bottommost vertex
+};
+
+template <typename Fn>
+size_t Rasterizer::Walk(i32 y0, i32 y1, size_t capacity, Fn &&fn) const {
+    if (m_count == 0 || capacity == 0) {
+        return 0;
+    }
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, kScreenHeight);
+
+    // Polygons with no height occupy a single scanline between their leftmost and rightmost vertices
+    if (m_top == m_bottom) {
+        if (m_top < y0 || m_top >= y1) {
+            return 0;
+        }
+        size_t leftVertex = 0;
+        size_t rightVertex = 0;
+        for (size_t i = 1; i < m_count; i++) {
+            if (m_vertices[i].x < m_vertices[leftVertex].x) {
+                leftVertex = i;
+            }
+            if (m_vertices[i].x > m_vertices[rightVertex].x) {
+                rightVertex = i;
+            }
+        }
+        const i32 left = m_vertices[leftVertex].x;
+        const i32 right = m_vertices[rightVertex].x;
+        if (right < 0 || left >= kScreenWidth) {
+            NDS_INTERP_COUNT(OffscreenScanlines, 1);
+            return 0;
+        }
+        fn(Span{m_top, ClampX(left), ClampX(right), ClampX(left), ClampX(right)}, leftVertex, rightVertex);
+        NDS_INTERP_COUNT(Spans, 1);
+        return 1;
+    }
+
+    const i32 top = std::max(m_top, y0);
+    const i32 bottom = std::min(m_bottom, y1);
+    if (top >= bottom) {
+        return 0;
+    }
+
+    Chain chainA = StartChain(m_topVertex, true, top);
+    Chain chainB = StartChain(m_topVertex, false, top);
+    size_t count = 0;
+    for (i32 y = top; y < bottom && count < capacity; y++) {
+        // Switch to the next edge of a chain once it reaches its lower vertex
+        if (y >= chainA.endY) {
+            chainA = StartChain(chainA.vertex, chainA.forward, y);
+        }
+        if (y >= chainB.endY) {
+            chainB = StartChain(chainB.vertex, chainB.forward, y);
+        }
+
+        Extent left = ChainExtent(chainA);
+        Extent right = ChainExtent(chainB);
+        size_t leftEdge = chainA.edge;
+        size_t rightEdge = chainB.edge;
+        chainA.stepper.Next();
+        chainB.stepper.Next();
+
+        // The edge further to the left is the left edge, regardless of the polygon's winding order
+        if (left.left > right.left || (left.left == right.left && left.right > right.right)) {
+            std::swap(left, right);
+            std::swap(leftEdge, rightEdge);
+        }
+        if (right.right < 0 || left.left >= kScreenWidth) {
+            NDS_INTERP_COUNT(OffscreenScanlines, 1);
+            continue;
+        }
+        fn(Span{y, ClampX(left.left), ClampX(right.right), ClampX(left.right), ClampX(right.left)}, leftEdge,
+           rightEdge);
+        NDS_INTERP_COUNT(Spans, 1);
+        count++;
+    }
+    return count;
+}
+
+/// <summary>
+/// The default height of the bands rasterized by RasterizeBands.
+/// </summary>
+/// <remarks>
+/// 16 scanlines split the screen into 12 bands, enough to keep several workers busy when the polygons are unevenly
+/// distributed over the screen while keeping the per-band overhead of positioning every edge low.
+/// </remarks>
+constexpr int32_t kDefaultBandHeight = 16;
+
+/// <summary>
+/// Rasterizes a set of prepared polygons in parallel by splitting the screen into horizontal bands.
+/// </summary>
+/// <remarks>
+/// The polygons are shared read-only by all workers; each worker rasterizes only the scanlines of its own band, from
+/// every polygon that overlaps it. For each band, fn(polygon, spans, count) is invoked once per polygon with at least
+/// one span in the band, in the order the polygons are specified, which preserves the drawing order of overlapping
+/// polygons within each scanline. Bands are processed concurrently on the threads of a pool owned by the caller, so fn
+/// must be safe to invoke from multiple threads at once; since bands never share a scanline, writing the spans to
+/// per-scanline storage (such as the rows of a framebuffer) needs no synchronization. No threads are started and no
+/// memory is allocated, so the same pool can rasterize every frame. fn must not use the pool itself.
+/// </remarks>
+/// <param name="pool">The worker threads that rasterize the bands</param>
+/// <param name="polygons">The polygons prepared by Rasterizer::Setup</param>
+/// <param name="count">The number of polygons</param>
+/// <param name="fn">The function that receives the spans of each polygon in each band</param>
+/// <param name="bandHeight">The number of scanlines in each band</param>
+template <typename Fn>
+void RasterizeBands(WorkerPool &pool, const Rasterizer *polygons, size_t count, Fn &&fn,
+                    int32_t bandHeight = kDefaultBandHeight) {
+    const int32_t numBands = (Rasterizer::kScreenHeight + bandHeight - 1) / bandHeight;
+    pool.Run(numBands, [&](size_t band) {
+        NDS_INTERP_TRACE_SCOPE("RasterizeBands band");
+        const int32_t y0 = (int32_t)band * bandHeight;
+        const int32_t y1 = std::min(y0 + bandHeight, Rasterizer::kScreenHeight);
+
+        std::array<Rasterizer::Span, Rasterizer::kScreenHeight> spans;
+        for (size_t i = 0; i < count; i++) {
+            // Bottom is exclusive, except on polygons with no height, which occupy the scanline of their top vertex
+            const Rasterizer &polygon = polygons[i];
+            const int32_t bottom = std::max(polygon.Bottom(), polygon.Top() + 1);
+            if (bottom <= y0 || polygon.Top() >= y1) {
+                continue;
+            }
+            const size_t numSpans = polygon.Rasterize(y0, y1, spans.data(), spans.size());
+            if (numSpans > 0) {
+                fn(i, spans.data(), numSpans);
+            }
+        }
+    });
+}
@@ -1,8 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 #include <utility>
 
+#include "instrument.h"
+
+template <size_t Capacity>
+class SlopeBatch;
+
 /// <summary>
 /// Computes 3D rasterization slopes based on Nintendo DS's hardware interpolation.
 /// </summary>
@@ -63,10 +72,30 @@
 ///   (511 as a raw integer with 9 fractional bits)
 ///
 /// All other operations are otherwise identical.
+///
+/// Edge anti-aliasing needs to know where the edge lies within the pixels it crosses. Coverage provides that from the
+/// fractional part of the starting coordinate of each span, which the interpolation computes anyway, so consumers do
+/// not have to interpolate the edges a second time. On Y-major slopes it locates the edge within the span's only pixel.
+/// On X-major slopes it locates the start of the span within its first pixel; the rest of the span follows from DX.
+///
+/// The precision of the interpolator is configurable through the template parameters. The Slope alias uses the
+/// hardware's 18 fractional bits and 32-bit integers and is pixel-perfect; other precisions run the same algorithm with
+/// the constants folded at compile time, for instance to interpolate at higher internal resolutions. The range of X
+/// coordinates is limited to 2^(B-1-FracBits), where B is the number of bits of Int, so higher precisions may need
+/// 64-bit integers.
 /// </remarks>
-class Slope {
+/// <typeparam name="FracBits">The number of fractional bits of the interpolator</typeparam>
+/// <typeparam name="Int">The signed integer type of fixed-point values and their intermediates</typeparam>
+/// <typeparam name="MaskBits">The number of least significant bits discarded from the ends of X-major spans</typeparam>
+template <uint32_t FracBits, typename Int = int32_t, uint32_t MaskBits = FracBits / 2>
+class BasicSlope {
     using u32 = uint32_t;
     using i32 = int32_t;
+    using UInt = std::make_unsigned_t<Int>;
+
+    static_assert(std::is_signed_v<Int>, "Int must be a signed integer type");
+    static_assert(FracBits + 2 < sizeof(Int) * 8, "Int is too narrow for the number of fractional bits");
+    static_assert(MaskBits < FracBits, "MaskBits must be less than FracBits");
 
 public:
     /// <summary>
@@ -75,23 +104,100 @@ public:
     /// <remarks>
     /// The Nintendo DS uses 18 fractional bits for interpolation.
     /// </remarks>
-    static constexpr u32 kFracBits = 18;
+    static constexpr u32 kFracBits = FracBits;
+
+    /// <summary>
+    /// The number of least significant fractional bits discarded from the ends of X-major spans.
+    /// </summary>
+    /// <remarks>
+    /// The Nintendo DS discards half of the fractional bits (rounded down), which is 9.
+    /// </remarks>
+    static constexpr u32 kMaskBits = MaskBits;
 
     /// <summary>
     /// The value 1.0 with fractional bits.
     /// </summary>
-    static constexpr u32 kOne = (1 << kFracBits);
+    static constexpr UInt kOne = ((UInt)1 << kFracBits);
 
     /// <summary>
     /// The bias applied to the interpolation of X-major spans.
     /// </summary>
-    static constexpr u32 kBias = (kOne >> 1);
+    static constexpr UInt kBias = (kOne >> 1);
+
+    /// <summary>
+    /// The mask applied during interpolation of X-major spans, removing the kMaskBits least significant fractional
+    /// bits.
+    /// </summary>
+    static constexpr UInt kMask = (~(UInt)0 << kMaskBits);
+
+    /// <summary>
+    /// The number of bits of the edge coverage values returned by Coverage.
+    /// </summary>
+    /// <remarks>
+    /// Coverage values use 5 bits like the alpha values of the Nintendo DS, so they can be blended the same way.
+    /// </remarks>
+    static constexpr u32 kCoverageBits = std::min(FracBits, 5u);
+
+    /// <summary>
+    /// The exclusive upper bound of edge coverage values, equivalent to 1.0.
+    /// </summary>
+    static constexpr u32 kCoverageOne = (1u << kCoverageBits);
 
     /// <summary>
-    /// The mask applied during interpolation of X-major spans, removing half of the least significant fractional bits
-    /// (rounded down).
+    /// Precomputed reciprocals of Y coordinate deltas with fractional bits, indexed by the delta.
     /// </summary>
-    static constexpr u32 kMask = (~0u << (kFracBits / 2));
+    /// <remarks>
+    /// The table covers every delta between two vertices on the 256x192 screen with plenty of room to spare for
+    /// clipping, replacing the integer division in Setup with a lookup. Each entry is the truncated result of 1.0 / dy,
+    /// except for entry 0, which holds 1.0 so that horizontal lines are interpolated as if the delta was 1.
+    /// </remarks>
+    static constexpr std::array<UInt, 257> kReciprocal = [] {
+        std::array<UInt, 257> table{};
+        table[0] = kOne;
+        for (UInt dy = 1; dy < table.size(); dy++) {
+            table[dy] = kOne / dy;
+        }
+        return table;
+    }();
+
+    /// <summary>
+    /// The span of a scanline as a run of pixels from left to right, regardless of the slope's orientation.
+    /// </summary>
+    struct Run {
+        i32 x;      // The leftmost pixel of the run
+        i32 length; // The number of pixels in the run, always at least 1
+        bool gap;   // Whether a gap separates the run from the previous scanline's run (X-major slopes only)
+    };
+
+    /// <summary>
+    /// A clipping rectangle in screen coordinates. The right and bottom edges are exclusive.
+    /// </summary>
+    struct ClipRect {
+        i32 left;   // The leftmost visible X coordinate
+        i32 top;    // The topmost visible Y coordinate
+        i32 right;  // The X coordinate past the rightmost visible pixel
+        i32 bottom; // The Y coordinate past the bottommost visible scanline
+    };
+
+    /// <summary>
+    /// The part of a slope that lies within a clipping rectangle.
+    /// </summary>
+    /// <remarks>
+    /// A scanline is visible if any pixel of its span lies within the clipping rectangle. The visible scanlines of a
+    /// slope are always consecutive, because both ends of the spans move monotonically in the direction of the slope.
+    /// </remarks>
+    struct VisibleRange {
+        i32 y0;   // The Y coordinate of the first visible scanline
+        i32 y1;   // The Y coordinate past the last visible scanline, equal to y0 if no scanline is visible
+        i32 xMin; // The leftmost visible pixel of the visible spans, clamped to the clipping rectangle
+        i32 xMax; // The rightmost visible pixel of the visible spans, clamped to the clipping rectangle
+
+        /// <summary>
+        /// Determines if no part of the slope is visible.
+        /// </summary>
+        /// <returns>true if there are no visible scanlines</returns>
+        constexpr bool IsEmpty() const { return y1 <= y0; }
+    };
 
     /// <summary>
     /// Configures the slope to interpolate the line (X0,X1)-(Y0,Y1) using screen coordinates.
@@ -108,7 +214,7 @@ public:
         }
 
         // Store reference coordinates
-        m_x0 = x0 << kFracBits;
+        m_x0 = (Int)x0 << kFracBits;
         m_y0 = y0;
 
         // Determine if this is a negative slope and adjust accordingly
@@ -122,6 +228,7 @@ public:
         i32 dx = (x1 - x0);
         i32 dy = (y1 - y0);
         m_xMajor = (dx > dy);
+        NDS_INTERP_COUNT_SETUP(m_negative, m_xMajor);
 
         // Precompute bias for X-major or diagonal slopes
         if (m_xMajor || dx == dy) {
@@ -134,11 +241,78 @@ public:
 
         // Compute X displacement per scanline
         m_dx = dx;
-        if (dy != 0) {
-            m_dx *= kOne / dy; // This ensures the division is performed before the multiplication
+        m_dx *= Reciprocal(dy); // This ensures the division is performed before the multiplication
+    }
+
+    /// <summary>
+    /// Configures the slope to interpolate the line (X0,X1)-(Y0,Y1) using screen coordinates and computes the part of
+    /// the slope that lies within a clipping rectangle.
+    /// </summary>
+    /// <remarks>
+    /// The slope covers the scanlines from the top endpoint up to, but excluding, the bottom endpoint, or a single
+    /// scanline for horizontal lines. Instead of computing the span of every scanline to discard the ones that fall
+    /// outside of the clipping rectangle, the first and last visible scanlines are located with a binary search on the
+    /// ends of the spans, which takes a handful of span computations regardless of the height of the slope. Iterating
+    /// from y0 to y1 of the result visits only the visible scanlines, producing the same spans as unclipped iteration.
+    /// </remarks>
+    /// <param name="x0">First X coordinate</param>
+    /// <param name="y0">First Y coordinate</param>
+    /// <param name="x1">Second X coordinate</param>
+    /// <param name="y1">Second Y coordinate</param>
+    /// <param name="clip">The clipping rectangle</param>
+    /// <returns>The visible scanlines and X range of the slope</returns>
+    constexpr VisibleRange Setup(i32 x0, i32 y0, i32 x1, i32 y1, const ClipRect &clip) {
+        Setup(x0, y0, x1, y1);
+
+        // Only the vertical extent of the line is needed from here on
+        const i32 top = std::min(y0, y1);
+        const i32 bottom = std::max(std::max(y0, y1), top + 1);
+        const i32 first = std::max(top, clip.top);
+        const i32 last = std::min(bottom, clip.bottom);
+        if (first >= last) {
+            return {first, first, clip.left, clip.left};
+        }
+
+        // Both ends of the spans move right on positive slopes and left on negative slopes, so the scanlines to the
+        // left of the clipping rectangle precede the visible scanlines on positive slopes and follow them on negative
+        // slopes, and the other way around for the scanlines to the right
+        auto leftOfClip = [&](i32 y) { return RightPixel(y) < clip.left; };
+        auto rightOfClip = [&](i32 y) { return LeftPixel(y) >= clip.right; };
+        VisibleRange range{};
+        if (m_negative) {
+            range.y0 = FirstScanline(first, last, [&](i32 y) { return !rightOfClip(y); });
+            range.y1 = FirstScanline(range.y0, last, leftOfClip);
         } else {
-            m_dx *= kOne;
+            range.y0 = FirstScanline(first, last, [&](i32 y) { return !leftOfClip(y); });
+            range.y1 = FirstScanline(range.y0, last, rightOfClip);
+        }
+        if (range.IsEmpty()) {
+            range.xMin = range.xMax = clip.left;
+            return range;
+        }
+
+        // The leftmost and rightmost pixels are found on the first and last visible scanlines
+        const i32 leftY = m_negative ? range.y1 - 1 : range.y0;
+        const i32 rightY = m_negative ? range.y0 : range.y1 - 1;
+        range.xMin = std::max(LeftPixel(leftY), clip.left);
+        range.xMax = std::min(RightPixel(rightY), clip.right - 1);
+        return range;
+    }
+
+    /// <summary>
+    /// Computes the reciprocal of a Y coordinate delta with fractional bits, as used by Setup to compute DX.
+    /// </summary>
+    /// <remarks>
+    /// Horizontal lines (where the delta is zero) are interpolated as if the delta was 1. Deltas covered by kReciprocal
+    /// are looked up from the table; larger deltas fall back to the division.
+    /// </remarks>
+    /// <param name="dy">The Y coordinate delta (Y1 - Y0), which must not be negative</param>
+    /// <returns>1.0 / dy, truncated</returns>
+    static constexpr UInt Reciprocal(i32 dy) {
+        if ((u32)dy < kReciprocal.size()) {
+            return kReciprocal[dy];
         }
+        return kOne / dy;
     }
 
     /// <summary>
@@ -146,12 +320,12 @@ public:
     /// </summary>
     /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
     /// <returns>The starting X coordinate of the specified scanline's span</returns>
-    constexpr i32 FracXStart(i32 y) const {
-        i32 displacement = (y - m_y0) * m_dx;
+    constexpr Int FracXStart(i32 y) const {
+        Int displacement = (Int)(y - m_y0) * m_dx;
         if (m_negative) {
-            return m_x0 - displacement;
+            return StartAt<true>(m_x0, displacement);
         } else {
-            return m_x0 + displacement;
+            return StartAt<false>(m_x0, displacement);
         }
     }
 
@@ -160,19 +334,7 @@ public:
     /// </summary>
     /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
     /// <returns>The ending X coordinate of the specified scanline's span</returns>
-    constexpr i32 FracXEnd(i32 y) const {
-        i32 result = FracXStart(y);
-        if (m_xMajor) {
-            if (m_negative) {
-                // The bit manipulation sequence (~mask - (x & ~mask)) acts like a ceiling function.
-                // Since we're working in the opposite direction here, the "floor" is actually the ceiling.
-                result = result + (~kMask - (result & ~kMask)) - m_dx + kOne;
-            } else {
-                result = (result & kMask) + m_dx - kOne;
-            }
-        }
-        return result;
-    }
+    constexpr Int FracXEnd(i32 y) const { return EndFromStart(FracXStart(y)); }
 
     /// <summary>
     /// Computes the starting position of the span at the specified Y coordinate as a screen coordinate (dropping the
@@ -180,7 +342,7 @@ public:
     /// </summary>
     /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
     /// <returns>The starting X screen coordinate of the scanline's span</returns>
-    constexpr i32 XStart(i32 y) const { return FracXStart(y) >> kFracBits; }
+    constexpr i32 XStart(i32 y) const { return (i32)(FracXStart(y) >> kFracBits); }
 
     /// <summary>
     /// Computes the ending position of the span at the specified Y coordinate as a screen coordinate (dropping the
@@ -188,13 +350,489 @@ public:
     /// </summary>
     /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
     /// <returns>The ending X screen coordinate of the scanline's span</returns>
-    constexpr i32 XEnd(i32 y) const { return FracXEnd(y) >> kFracBits; }
+    constexpr i32 XEnd(i32 y) const { return (i32)(FracXEnd(y) >> kFracBits); }
+
+    /// <summary>
+    /// Computes the edge coverage of the span at the specified Y coordinate.
+    /// </summary>
+    /// <remarks>
+    /// The coverage is the position of the edge within the starting pixel of the span, measured in the direction of the
+    /// slope: from the left side of the pixel on positive slopes and from the right side on negative slopes, so that
+    /// mirrored slopes have identical coverage. It is the fractional part of FracXStart truncated to kCoverageBits.
+    /// </remarks>
+    /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
+    /// <returns>The edge coverage, from 0 up to but excluding kCoverageOne</returns>
+    constexpr u32 Coverage(i32 y) const {
+        if (m_negative) {
+            return CoverageAt<true>(FracXStart(y));
+        } else {
+            return CoverageAt<false>(FracXStart(y));
+        }
+    }
+
+    /// <summary>
+    /// Incrementally computes the spans of consecutive scanlines of a slope, top to bottom.
+    /// </summary>
+    /// <remarks>
+    /// The stepper produces exactly the same values as FracXStart and FracXEnd, but instead of recomputing the
+    /// displacement (Y - Y0) * DX on every scanline, it accumulates DX into the starting coordinate as it advances. The
+    /// ending coordinate is derived from the current starting coordinate, so each scanline costs a single addition
+    /// plus the X-major masking.
+    /// </remarks>
+    class Stepper {
+    public:
+        /// <summary>
+        /// Retrieves the Y coordinate of the current scanline.
+        /// </summary>
+        /// <returns>The current Y coordinate</returns>
+        constexpr i32 Y() const { return m_y; }
+
+        /// <summary>
+        /// Retrieves the starting position of the current scanline's span, including the fractional part.
+        /// </summary>
+        /// <returns>The starting X coordinate of the current scanline's span</returns>
+        constexpr Int FracXStart() const { return m_x; }
+
+        /// <summary>
+        /// Retrieves the ending position of the current scanline's span, including the fractional part.
+        /// </summary>
+        /// <returns>The ending X coordinate of the current scanline's span</returns>
+        constexpr Int FracXEnd() const { return m_slope->EndFromStart(m_x); }
+
+        /// <summary>
+        /// Retrieves the starting position of the current scanline's span as a screen coordinate.
+        /// </summary>
+        /// <returns>The starting X screen coordinate of the current scanline's span</returns>
+        constexpr i32 XStart() const { return (i32)(FracXStart() >> kFracBits); }
+
+        /// <summary>
+        /// Retrieves the ending position of the current scanline's span as a screen coordinate.
+        /// </summary>
+        /// <returns>The ending X screen coordinate of the current scanline's span</returns>
+        constexpr i32 XEnd() const { return (i32)(FracXEnd() >> kFracBits); }
+
+        /// <summary>
+        /// Retrieves the edge coverage of the current scanline's span. See Slope::Coverage.
+        /// </summary>
+        /// <returns>The edge coverage of the current scanline's span</returns>
+        constexpr u32 Coverage() const {
+            return m_slope->m_negative ? CoverageAt<true>(m_x) : CoverageAt<false>(m_x);
+        }
+
+        /// <summary>
+        /// Advances to the next scanline.
+        /// </summary>
+        constexpr void Next() {
+            m_x += m_step;
+            m_y++;
+        }
+
+    private:
+        constexpr Stepper(const BasicSlope &slope, i32 y)
+            : m_slope(&slope)
+            , m_x(slope.FracXStart(y))
+            , m_step(slope.m_negative ? -slope.m_dx : slope.m_dx)
+            , m_y(y) {}
+
+        const BasicSlope *m_slope; // The slope being stepped through
+        Int m_x;                   // Starting X coordinate of the current scanline's span
+        Int m_step;                // Signed X displacement per scanline
+        i32 m_y;                   // Current Y coordinate
+
+        friend class BasicSlope;
+    };
+
+    /// <summary>
+    /// Creates a stepper positioned at the specified Y coordinate.
+    /// </summary>
+    /// <param name="y">
+    /// The Y coordinate of the first scanline, which must be between Y0 and Y1 specified in Setup.
+    /// </param>
+    /// <returns>A stepper that walks the slope's scanlines from the specified Y coordinate downwards</returns>
+    constexpr Stepper Begin(i32 y) const { return Stepper{*this, y}; }
+
+    /// <summary>
+    /// A view of a slope whose orientation is fixed at compile time.
+    /// </summary>
+    /// <remarks>
+    /// The orientation of a slope (negative or positive, X-major or Y-major) is determined once by Setup and never
+    /// changes afterwards, yet FracXStart and FracXEnd check it on every scanline. This view computes the same values
+    /// without any branches on the orientation. Use Slope::Dispatch to obtain the view matching a configured slope.
+    /// </remarks>
+    /// <typeparam name="Negative">Whether the slope is negative</typeparam>
+    /// <typeparam name="XMajor">Whether the slope is X-major</typeparam>
+    template <bool Negative, bool XMajor>
+    class Oriented {
+    public:
+        /// <summary>
+        /// Whether the slope is negative (i.e. X decreases as Y increases).
+        /// </summary>
+        static constexpr bool kNegative = Negative;
+
+        /// <summary>
+        /// Whether the slope is X-major.
+        /// </summary>
+        static constexpr bool kXMajor = XMajor;
+
+        /// <summary>
+        /// Creates a view of the specified slope, which must have been configured with a matching orientation.
+        /// </summary>
+        /// <param name="slope">The slope to view</param>
+        constexpr explicit Oriented(const BasicSlope &slope)
+            : m_x0(slope.m_x0)
+            , m_y0(slope.m_y0)
+            , m_dx(slope.m_dx) {}
+
+        /// <summary>
+        /// Computes the starting position of the span at the specified Y coordinate, including the fractional part.
+        /// </summary>
+        /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
+        /// <returns>The starting X coordinate of the specified scanline's span</returns>
+        constexpr Int FracXStart(i32 y) const { return StartAt<Negative>(m_x0, (Int)(y - m_y0) * m_dx); }
+
+        /// <summary>
+        /// Computes the ending position of the span at the specified Y coordinate, including the fractional part.
+        /// </summary>
+        /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
+        /// <returns>The ending X coordinate of the specified scanline's span</returns>
+        constexpr Int FracXEnd(i32 y) const { return EndAt<Negative, XMajor>(FracXStart(y), m_dx); }
+
+        /// <summary>
+        /// Computes the starting position of the span at the specified Y coordinate as a screen coordinate.
+        /// </summary>
+        /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
+        /// <returns>The starting X screen coordinate of the scanline's span</returns>
+        constexpr i32 XStart(i32 y) const { return (i32)(FracXStart(y) >> kFracBits); }
+
+        /// <summary>
+        /// Computes the ending position of the span at the specified Y coordinate as a screen coordinate.
+        /// </summary>
+        /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
+        /// <returns>The ending X screen coordinate of the scanline's span</returns>
+        constexpr i32 XEnd(i32 y) const { return (i32)(FracXEnd(y) >> kFracBits); }
+
+        /// <summary>
+        /// Computes the edge coverage of the span at the specified Y coordinate. See Slope::Coverage.
+        /// </summary>
+        /// <param name="y">The Y coordinate, which must be between Y0 and Y1 specified in Setup.</param>
+        /// <returns>The edge coverage, from 0 up to but excluding kCoverageOne</returns>
+        constexpr u32 Coverage(i32 y) const { return CoverageAt<Negative>(FracXStart(y)); }
+
+        /// <summary>
+        /// Retrieves the X coordinate increment per scanline.
+        /// </summary>
+        /// <returns>The X displacement per scanline (DX)</returns>
+        constexpr Int DX() const { return m_dx; }
+
+        /// <summary>
+        /// Computes the spans of a range of scanlines as screen coordinates. See Slope::GenerateSpans.
+        /// </summary>
+        /// <param name="y0">The Y coordinate of the first scanline</param>
+        /// <param name="y1">The Y coordinate past the last scanline</param>
+        /// <param name="starts">The array that receives the starting X screen coordinates of the spans</param>
+        /// <param name="ends">The array that receives the ending X screen coordinates of the spans</param>
+        constexpr void GenerateSpans(i32 y0, i32 y1, i32 *starts, i32 *ends) const {
+            // Each scanline is computed independently from the others so that the loop can be vectorized
+            const i32 offset = y0 - m_y0;
+            const i32 count = y1 - y0;
+            NDS_INTERP_COUNT(Spans, count);
+            for (i32 i = 0; i < count; i++) {
+                const Int start = StartAt<Negative>(m_x0, (Int)(offset + i) * m_dx);
+                starts[i] = (i32)(start >> kFracBits);
+                ends[i] = (i32)(EndAt<Negative, XMajor>(start, m_dx) >> kFracBits);
+            }
+        }
+
+        /// <summary>
+        /// Computes the spans of a range of scanlines as screen coordinates along with their edge coverage. See
+        /// Slope::GenerateSpans.
+        /// </summary>
+        /// <param name="y0">The Y coordinate of the first scanline</param>
+        /// <param name="y1">The Y coordinate past the last scanline</param>
+        /// <param name="starts">The array that receives the starting X screen coordinates of the spans</param>
+        /// <param name="ends">The array that receives the ending X screen coordinates of the spans</param>
+        /// <param name="coverage">The array that receives the edge coverage of the spans</param>
+        constexpr void GenerateSpans(i32 y0, i32 y1, i32 *starts, i32 *ends, u32 *coverage) const {
+            const i32 offset = y0 - m_y0;
+            const i32 count = y1 - y0;
+            NDS_INTERP_COUNT(Spans, count);
+            for (i32 i = 0; i < count; i++) {
+                const Int start = StartAt<Negative>(m_x0, (Int)(offset + i) * m_dx);
+                starts[i] = (i32)(start >> kFracBits);
+                ends[i] = (i32)(EndAt<Negative, XMajor>(start, m_dx) >> kFracBits);
+                coverage[i] = CoverageAt<Negative>(start);
+            }
+        }
+
+        /// <summary>
+        /// Computes the spans of a range of scanlines as left-to-right runs. See Slope::GenerateRuns.
+        /// </summary>
+        /// <param name="y0">The Y coordinate of the first scanline</param>
+        /// <param name="y1">The Y coordinate past the last scanline</param>
+        /// <param name="runs">The array that receives the runs</param>
+        constexpr void GenerateRuns(i32 y0, i32 y1, Run *runs) const {
+            // The end of the previous scanline's span is carried over to detect gaps
+            const i32 offset = y0 - m_y0;
+            const i32 count = y1 - y0;
+            NDS_INTERP_COUNT(Spans, count);
+            i32 prevEnd = (i32)(EndAt<Negative, XMajor>(StartAt<Negative>(m_x0, (Int)(offset - 1) * m_dx), m_dx) >>
+                                kFracBits);
+            for (i32 i = 0; i < count; i++) {
+                const Int start = StartAt<Negative>(m_x0, (Int)(offset + i) * m_dx);
+                const i32 xStart = (i32)(start >> kFracBits);
+                const i32 xEnd = (i32)(EndAt<Negative, XMajor>(start, m_dx) >> kFracBits);
+
+                // Only X-major slopes have gaps, and the first scanline of the slope has no previous scanline
+                const bool hasPrev = XMajor && (offset + i > 0);
+                if constexpr (Negative) {
+                    runs[i] = {xEnd, xStart - xEnd + 1, hasPrev && (prevEnd - xStart > 1)};
+                } else {
+                    runs[i] = {xStart, xEnd - xStart + 1, hasPrev && (xStart - prevEnd > 1)};
+                }
+                NDS_INTERP_COUNT(Gaps, runs[i].gap);
+                prevEnd = xEnd;
+            }
+        }
+
+        /// <summary>
+        /// Computes the spans of Scale sub-scanlines per scanline at Scale times the resolution. See
+        /// Slope::GenerateSubSpans.
+        /// </summary>
+        /// <typeparam name="Scale">The resolution multiplier</typeparam>
+        /// <param name="y0">The Y coordinate of the first scanline</param>
+        /// <param name="y1">The Y coordinate past the last scanline</param>
+        /// <param name="starts">The array that receives the starting X coordinates of the sub-spans</param>
+        /// <param name="ends">The array that receives the ending X coordinates of the sub-spans</param>
+        template <i32 Scale>
+        constexpr void GenerateSubSpans(i32 y0, i32 y1, i32 *starts, i32 *ends) const {
+            static_assert(Scale >= 1, "Scale must be positive");
+
+            const i32 offset = y0 - m_y0;
+            const i32 count = y1 - y0;
+            NDS_INTERP_COUNT(Spans, count);
+            for (i32 i = 0; i < count; i++) {
+                const Int start = StartAt<Negative>(m_x0, (Int)(offset + i) * m_dx);
+                const i32 x = (i32)(start >> kFracBits);
+                i32 *subStarts = &starts[i * Scale];
+                i32 *subEnds = &ends[i * Scale];
+                if constexpr (XMajor) {
+                    // Split the scaled span evenly among the sub-scanlines in the direction of the slope. The sub-spans
+                    // cover exactly the scaled span, so the gaps between spans are scaled along with them.
+                    const i32 xEnd = (i32)(EndAt<Negative, XMajor>(start, m_dx) >> kFracBits);
+                    if constexpr (Negative) {
+                        const i32 width = x - xEnd + 1;
+                        for (i32 k = 0; k < Scale; k++) {
+                            subStarts[k] = x * Scale + Scale - 1 - k * width;
+                            subEnds[k] = subStarts[k] - width + 1;
+                        }
+                    } else {
+                        const i32 width = xEnd - x + 1;
+                        for (i32 k = 0; k < Scale; k++) {
+                            subStarts[k] = x * Scale + k * width;
+                            subEnds[k] = subStarts[k] + width - 1;
+                        }
+                    }
+                } else {
+                    // Interpolate each sub-scanline at the higher resolution, without leaving the scaled pixel
+                    const Int x0 = m_x0 * Scale;
+                    for (i32 k = 0; k < Scale; k++) {
+                        const Int subStart = StartAt<Negative>(x0, ((Int)(offset + i) * Scale + k) * m_dx);
+                        const i32 subX = (i32)(subStart >> kFracBits);
+                        subStarts[k] = std::clamp(subX, x * Scale, x * Scale + Scale - 1);
+                        subEnds[k] = subStarts[k];
+                    }
+                }
+            }
+        }
+
+        /// <summary>
+        /// Incrementally computes the spans of consecutive scanlines, top to bottom, without branches.
+        /// </summary>
+        class Stepper {
+        public:
+            /// <summary>
+            /// Retrieves the Y coordinate of the current scanline.
+            /// </summary>
+            /// <returns>The current Y coordinate</returns>
+            constexpr i32 Y() const { return m_y; }
+
+            /// <summary>
+            /// Retrieves the starting position of the current scanline's span, including the fractional part.
+            /// </summary>
+            /// <returns>The starting X coordinate of the current scanline's span</returns>
+            constexpr Int FracXStart() const { return m_x; }
+
+            /// <summary>
+            /// Retrieves the ending position of the current scanline's span, including the fractional part.
+            /// </summary>
+            /// <returns>The ending X coordinate of the current scanline's span</returns>
+            constexpr Int FracXEnd() const { return EndAt<Negative, XMajor>(m_x, m_dx); }
+
+            /// <summary>
+            /// Retrieves the starting position of the current scanline's span as a screen coordinate.
+            /// </summary>
+            /// <returns>The starting X screen coordinate of the current scanline's span</returns>
+            constexpr i32 XStart() const { return (i32)(FracXStart() >> kFracBits); }
+
+            /// <summary>
+            /// Retrieves the ending position of the current scanline's span as a screen coordinate.
+            /// </summary>
+            /// <returns>The ending X screen coordinate of the current scanline's span</returns>
+            constexpr i32 XEnd() const { return (i32)(FracXEnd() >> kFracBits); }
+
+            /// <summary>
+            /// Retrieves the edge coverage of the current scanline's span. See Slope::Coverage.
+            /// </summary>
+            /// <returns>The edge coverage of the current scanline's span</returns>
+            constexpr u32 Coverage() const { return CoverageAt<Negative>(m_x); }
+
+            /// <summary>
+            /// Advances to the next scanline.
+            /// </summary>
+            constexpr void Next() {
+                m_x = StartAt<Negative>(m_x, m_dx);
+                m_y++;
+            }
+
+        private:
+            constexpr Stepper(const Oriented &slope, i32 y)
+                : m_x(slope.FracXStart(y))
+                , m_dx(slope.m_dx)
+                , m_y(y) {}
+
+            Int m_x;  // Starting X coordinate of the current scanline's span
+            Int m_dx; // X displacement per scanline
+            i32 m_y;  // Current Y coordinate
+
+            friend class Oriented;
+        };
+
+        /// <summary>
+        /// Creates a stepper positioned at the specified Y coordinate.
+        /// </summary>
+        /// <param name="y">
+        /// The Y coordinate of the first scanline, which must be between Y0 and Y1 specified in Setup.
+        /// </param>
+        /// <returns>A stepper that walks the slope's scanlines from the specified Y coordinate downwards</returns>
+        constexpr Stepper Begin(i32 y) const { return Stepper{*this, y}; }
+
+    private:
+        Int m_x0; // X0 coordinate (minus 1 if this is a negative slope)
+        i32 m_y0; // Y0 coordinate
+        Int m_dx; // X displacement per scanline
+    };
+
+    /// <summary>
+    /// Invokes a function with the Oriented view matching this slope's orientation.
+    /// </summary>
+    /// <remarks>
+    /// The orientation is checked once here instead of on every scanline. The function is instantiated for all four
+    /// orientations, so it is typically a generic lambda taking an <c>auto</c> parameter, and all instantiations must
+    /// return the same type.
+    /// </remarks>
+    /// <param name="fn">The function to invoke with an Oriented view of this slope</param>
+    /// <returns>The value returned by the function</returns>
+    template <typename Fn>
+    constexpr decltype(auto) Dispatch(Fn &&fn) const {
+        if (m_negative) {
+            if (m_xMajor) {
+                return fn(Oriented<true, true>{*this});
+            } else {
+                return fn(Oriented<true, false>{*this});
+            }
+        } else {
+            if (m_xMajor) {
+                return fn(Oriented<false, true>{*this});
+            } else {
+                return fn(Oriented<false, false>{*this});
+            }
+        }
+    }
+
+    /// <summary>
+    /// Computes the spans of a range of scanlines as screen coordinates, writing the starting and ending coordinates
+    /// into separate arrays.
+    /// </summary>
+    /// <remarks>
+    /// The span of scanline Y0+i is written to starts[i] and ends[i], producing the same values as XStart(Y0+i) and
+    /// XEnd(Y0+i). Both arrays must have room for at least Y1-Y0 elements. As with XStart and XEnd, the starting
+    /// coordinate is the rightmost pixel of the span on negative slopes.
+    /// </remarks>
+    /// <param name="y0">The Y coordinate of the first scanline, between Y0 and Y1 specified in Setup</param>
+    /// <param name="y1">The Y coordinate past the last scanline, not past Y1 specified in Setup</param>
+    /// <param name="starts">The array that receives the starting X screen coordinates of the spans</param>
+    /// <param name="ends">The array that receives the ending X screen coordinates of the spans</param>
+    constexpr void GenerateSpans(i32 y0, i32 y1, i32 *starts, i32 *ends) const {
+        Dispatch([&](auto slope) { slope.GenerateSpans(y0, y1, starts, ends); });
+    }
+
+    /// <summary>
+    /// Computes the spans of a range of scanlines as screen coordinates along with their edge coverage, in a single
+    /// pass.
+    /// </summary>
+    /// <remarks>
+    /// The spans are identical to those of the overload without coverage, and coverage[i] receives the same value as
+    /// Coverage(Y0+i). All three arrays must have room for at least Y1-Y0 elements.
+    /// </remarks>
+    /// <param name="y0">The Y coordinate of the first scanline, between Y0 and Y1 specified in Setup</param>
+    /// <param name="y1">The Y coordinate past the last scanline, not past Y1 specified in Setup</param>
+    /// <param name="starts">The array that receives the starting X screen coordinates of the spans</param>
+    /// <param name="ends">The array that receives the ending X screen coordinates of the spans</param>
+    /// <param name="coverage">The array that receives the edge coverage of the spans</param>
+    constexpr void GenerateSpans(i32 y0, i32 y1, i32 *starts, i32 *ends, u32 *coverage) const {
+        Dispatch([&](auto slope) { slope.GenerateSpans(y0, y1, starts, ends, coverage); });
+    }
+
+    /// <summary>
+    /// Computes the spans of a range of scanlines as runs of pixels from left to right.
+    /// </summary>
+    /// <remarks>
+    /// The run of scanline Y0+i is written to runs[i]. It covers the same pixels as XStart(Y0+i) and XEnd(Y0+i), but
+    /// always starts at the leftmost pixel, so fill loops need no special handling of negative slopes. The gap flag is
+    /// set on the runs of X-major slopes that are separated from the previous scanline's run by at least one pixel,
+    /// such as row 38 of 69x49 slopes. The array must have room for at least Y1-Y0 elements.
+    /// </remarks>
+    /// <param name="y0">The Y coordinate of the first scanline, between Y0 and Y1 specified in Setup</param>
+    /// <param name="y1">The Y coordinate past the last scanline, not past Y1 specified in Setup</param>
+    /// <param name="runs">The array that receives the runs</param>
+    constexpr void GenerateRuns(i32 y0, i32 y1, Run *runs) const {
+        Dispatch([&](auto slope) { slope.GenerateRuns(y0, y1, runs); });
+    }
+
+    /// <summary>
+    /// Computes the spans of a range of scanlines at Scale times the resolution, producing Scale sub-scanlines per
+    /// scanline whose spans are in scaled X coordinates.
+    /// </summary>
+    /// <remarks>
+    /// The sub-spans are derived from the hardware spans so that the slope looks as it does on hardware when scaled
+    /// up, including the one-pixel gaps of X-major slopes:
+    /// - X-major spans are scaled and split evenly among the sub-scanlines, from left to right on positive slopes and
+    ///   from right to left on negative slopes. Together, the sub-spans of a scanline cover exactly its scaled span,
+    ///   so a one-pixel gap becomes a Scale-pixel gap.
+    /// - Y-major slopes are interpolated at each sub-scanline with Scale times the resolution, and each sub-scanline
+    ///   is kept within the scaled pixel of its scanline.
+    ///
+    /// Sub-scanline k of scanline Y0+i is written to starts[i*Scale+k] and ends[i*Scale+k]. Both arrays must have room
+    /// for at least (Y1-Y0)*Scale elements. As with GenerateSpans, the starting coordinate is the rightmost pixel of
+    /// the sub-span on negative slopes. With a Scale of 1, the results are identical to those of GenerateSpans.
+    ///
+    /// The scaled coordinates must fit in Int along with the fractional bits; use a 64-bit Int for large scales.
+    /// </remarks>
+    /// <typeparam name="Scale">The resolution multiplier</typeparam>
+    /// <param name="y0">The Y coordinate of the first scanline, between Y0 and Y1 specified in Setup</param>
+    /// <param name="y1">The Y coordinate past the last scanline, not past Y1 specified in Setup</param>
+    /// <param name="starts">The array that receives the starting scaled X coordinates of the sub-spans</param>
+    /// <param name="ends">The array that receives the ending scaled X coordinates of the sub-spans</param>
+    template <i32 Scale>
+    constexpr void GenerateSubSpans(i32 y0, i32 y1, i32 *starts, i32 *ends) const {
+        Dispatch([&](auto slope) { slope.template GenerateSubSpans<Scale>(y0, y1, starts, ends); });
+    }
 
     /// <summary>
     /// Retrieves the X coordinate increment per scanline.
     /// </summary>
     /// <returns>The X displacement per scanline (DX)</returns>
-    constexpr i32 DX() const { return m_dx; }
+    constexpr Int DX() const { return m_dx; }
 
     /// <summary>
     /// Determines if the slope is X-major.
@@ -208,10 +846,124 @@ public:
     /// <returns>true if the slope is negative.</returns>
     constexpr bool IsNegative() const { return m_negative; }
 
+    /// <summary>
+    /// Retrieves the X0 coordinate with fractional bits, adjusted for bias and negative slopes as computed by Setup.
+    /// </summary>
+    /// <returns>The X0 coordinate with fractional bits</returns>
+    constexpr Int X0() const { return m_x0; }
+
+    /// <summary>
+    /// Retrieves the Y coordinate of the top endpoint of the slope.
+    /// </summary>
+    /// <returns>The Y0 coordinate</returns>
+    constexpr i32 Y0() const { return m_y0; }
+
+    /// <summary>
+    /// Restores a slope from the parameters computed by Setup, as returned by X0, Y0, DX, IsNegative and IsXMajor.
+    /// </summary>
+    /// <remarks>
+    /// This allows slopes to be stored in a different form, such as in save states or across the C API, and turned
+    /// back into slopes without repeating the setup.
+    /// </remarks>
+    /// <param name="x0">The X0 coordinate with fractional bits</param>
+    /// <param name="y0">The Y0 coordinate</param>
+    /// <param name="dx">The X displacement per scanline</param>
+    /// <param name="negative">Whether the slope is negative</param>
+    /// <param name="xMajor">Whether the slope is X-major</param>
+    /// <returns>A slope configured identically to the one the parameters were retrieved from</returns>
+    static constexpr BasicSlope FromParameters(Int x0, i32 y0, Int dx, bool negative, bool xMajor) {
+        BasicSlope slope{};
+        slope.m_x0 = x0;
+        slope.m_y0 = y0;
+        slope.m_dx = dx;
+        slope.m_negative = negative;
+        slope.m_xMajor = xMajor;
+        return slope;
+    }
+
 private:
-    i32 m_x0;        // X0 coordinate (minus 1 if this is a negative slope)
+    // Retrieves the leftmost pixel of the span at the specified Y coordinate
+    constexpr i32 LeftPixel(i32 y) const { return m_negative ? XEnd(y) : XStart(y); }
+
+    // Retrieves the rightmost pixel of the span at the specified Y coordinate
+    constexpr i32 RightPixel(i32 y) const { return m_negative ? XStart(y) : XEnd(y); }
+
+    // Finds the first scanline in [y0, y1) for which pred is true, or y1 if there is none. pred must be false up to
+    // some scanline and true from there on.
+    template <typename Pred>
+    static constexpr i32 FirstScanline(i32 y0, i32 y1, Pred &&pred) {
+        while (y0 < y1) {
+            const i32 mid = y0 + (y1 - y0) / 2;
+            if (pred(mid)) {
+                y1 = mid;
+            } else {
+                y0 = mid + 1;
+            }
+        }
+        return y0;
+    }
+
+    // Computes the starting position of a span displaced from X0
+    template <bool Negative>
+    static constexpr Int StartAt(Int x0, Int displacement) {
+        if constexpr (Negative) {
+            return x0 - displacement;
+        } else {
+            return x0 + displacement;
+        }
+    }
+
+    // Computes the edge coverage of a span from its starting position. The fractional part of negative slopes is
+    // inverted, which mirrors it exactly since their X0 is offset by one raw unit.
+    template <bool Negative>
+    static constexpr u32 CoverageAt(Int start) {
+        UInt frac = (UInt)start & (kOne - 1);
+        if constexpr (Negative) {
+            frac = (kOne - 1) - frac;
+        }
+        return (u32)(frac >> (kFracBits - kCoverageBits));
+    }
+
+    // Computes the ending position of a span from its starting position
+    template <bool Negative, bool XMajor>
+    static constexpr Int EndAt(Int start, Int dx) {
+        Int result = start;
+        if constexpr (XMajor) {
+            if constexpr (Negative) {
+                // The bit manipulation sequence (~mask - (x & ~mask)) acts like a ceiling function.
+                // Since we're working in the opposite direction here, the "floor" is actually the ceiling.
+                result = result + (~kMask - (result & ~kMask)) - dx + kOne;
+            } else {
+                result = (result & kMask) + dx - kOne;
+            }
+        }
+        return result;
+    }
+
+    // Computes the ending position of a span from its starting position using the slope's orientation
+    constexpr Int EndFromStart(Int start) const {
+        if (m_xMajor) {
+            if (m_negative) {
+                return EndAt<true, true>(start, m_dx);
+            } else {
+                return EndAt<false, true>(start, m_dx);
+            }
+        }
+        return start;
+    }
+
+    Int m_x0;        // X0 coordinate (minus 1 if this is a negative slope)
     i32 m_y0;        // Y0 coordinate
-    i32 m_dx;        // X displacement per scanline
+    Int m_dx;        // X displacement per scanline
     bool m_negative; // True if the slope is negative (X1 < X0)
     bool m_xMajor;   // True if the slope is X-major (X1-X0 > Y1-Y0)
+
+    template <size_t Capacity>
+    friend class SlopeBatch;
 };
+
+/// <summary>
+/// Computes 3D rasterization slopes with the Nintendo DS's interpolation precision: 18 fractional bits in 32-bit
+/// integers. See BasicSlope for details.
+/// </summary>
+using Slope = BasicSlope<18>;
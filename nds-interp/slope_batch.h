@@ -0,0 +1,232 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_arena.h"
+#include "slope.h"
+
+/// <summary>
+/// Configures and stores a batch of slopes in structure-of-arrays form.
+/// </summary>
+/// <remarks>
+/// Setup produces exactly the same parameters as calling Slope::Setup on each edge individually, but processes all
+/// edges in loops without branches so that the compiler can vectorize them. Batches with an edge taller than the
+/// reciprocal table go through a variant of the loop with the division fallback, which does not vectorize. The
+/// parameters of each slope are stored in separate arrays, which allows consumers to process many edges at once too.
+///
+/// The loops only outrun Slope::Setup when they are compiled for AVX2, where they take about 1.3 ns per edge against
+/// 1.7 to 2.6 ns. The baseline x86-64 instruction set has no 32-bit multiplication, gather, minimum or blend, which
+/// leaves the vectorized loops at about 2.7 ns per edge, although they do not slow down on edges in random order.
+///
+/// GenerateSpans computes the spans of every slope of the batch into a FrameArena, storing the spans of the whole batch
+/// contiguously instead of in a container per slope.
+/// </remarks>
+/// <typeparam name="Capacity">The maximum number of slopes in the batch</typeparam>
+template <size_t Capacity>
+class SlopeBatch {
+    using u8 = uint8_t;
+    using i32 = int32_t;
+
+public:
+    /// <summary>
+    /// The maximum number of slopes in the batch.
+    /// </summary>
+    static constexpr size_t kCapacity = Capacity;
+
+    /// <summary>
+    /// The spans of one slope of the batch stored in a FrameArena.
+    /// </summary>
+    struct Spans {
+        const i32 *starts; // Starting X screen coordinates of each scanline, identical to Slope::XStart
+        const i32 *ends;   // Ending X screen coordinates of each scanline, identical to Slope::XEnd
+        i32 y0;            // Y coordinate of the first scanline
+        i32 lines;         // Number of scanlines
+    };
+
+    /// <summary>
+    /// Configures the batch to interpolate the lines (X0[i],Y0[i])-(X1[i],Y1[i]) using screen coordinates.
+    /// </summary>
+    /// <remarks>
+    /// Replaces any slopes previously configured in the batch. Counts larger than the capacity are truncated.
+    /// </remarks>
+    /// <param name="x0">First X coordinates</param>
+    /// <param name="y0">First Y coordinates</param>
+    /// <param name="x1">Second X coordinates</param>
+    /// <param name="y1">Second Y coordinates</param>
+    /// <param name="count">The number of slopes to configure</param>
+    constexpr void Setup(const i32 *x0, const i32 *y0, const i32 *x1, const i32 *y1, size_t count) {
+        if (count > Capacity) {
+            count = Capacity;
+        }
+        m_count = count;
+
+        // Deltas past the end of the reciprocal table need a division, which keeps the loop from vectorizing. The
+        // largest delta is found once for the whole batch, so that batches without long edges use the table alone.
+        u32 maxDY = 0;
+        for (size_t i = 0; i < count; i++) {
+            const u32 dy = (y1[i] < y0[i]) ? ((u32)y0[i] - (u32)y1[i]) : ((u32)y1[i] - (u32)y0[i]);
+            maxDY = (dy > maxDY) ? dy : maxDY;
+        }
+        if (maxDY < Slope::kReciprocal.size()) {
+            SetupEdges<true>(x0, y0, x1, y1, count);
+        } else {
+            SetupEdges<false>(x0, y0, x1, y1, count);
+        }
+
+        // The flags are stored in a separate loop because mixing byte and word stores keeps the loops above from
+        // vectorizing. Swapping the endpoints flips the sign of both deltas, so the flags follow from the raw deltas.
+        for (size_t i = 0; i < count; i++) {
+            const i32 dx = x1[i] - x0[i];
+            const i32 dy = y1[i] - y0[i];
+            const i32 absDX = (dx < 0) ? -dx : dx;
+            const i32 absDY = (dy < 0) ? -dy : dy;
+            m_negative[i] = (dy < 0) ? (dx > 0) : (dx < 0);
+            m_xMajor[i] = (absDX > absDY);
+        }
+
+#ifdef NDS_INTERP_INSTRUMENT
+        // Counted in a separate loop to keep the setup loop vectorizable in instrumented builds
+        for (size_t i = 0; i < count; i++) {
+            NDS_INTERP_COUNT_SETUP(m_negative[i] != 0, m_xMajor[i] != 0);
+        }
+#endif
+    }
+
+    /// <summary>
+    /// Retrieves the number of slopes in the batch.
+    /// </summary>
+    /// <returns>The number of slopes configured by the last call to Setup</returns>
+    constexpr size_t Size() const { return m_count; }
+
+    /// <summary>
+    /// Retrieves a copy of one of the slopes of the batch.
+    /// </summary>
+    /// <param name="index">The index of the slope, which must be less than Size()</param>
+    /// <returns>A slope configured identically to the one at the specified index</returns>
+    constexpr Slope Get(size_t index) const {
+        Slope slope{};
+        slope.m_x0 = m_x0[index];
+        slope.m_y0 = m_y0[index];
+        slope.m_dx = m_dx[index];
+        slope.m_negative = m_negative[index] != 0;
+        slope.m_xMajor = m_xMajor[index] != 0;
+        return slope;
+    }
+
+    /// <summary>
+    /// Retrieves the array of X0 coordinates with fractional bits (adjusted for bias and negative slopes).
+    /// </summary>
+    /// <returns>A pointer to the first of Size() X0 coordinates</returns>
+    constexpr const i32 *X0() const { return m_x0.data(); }
+
+    /// <summary>
+    /// Retrieves the array of Y0 coordinates.
+    /// </summary>
+    /// <returns>A pointer to the first of Size() Y0 coordinates</returns>
+    constexpr const i32 *Y0() const { return m_y0.data(); }
+
+    /// <summary>
+    /// Retrieves the array of Y coordinates past the last scanline of each slope. Horizontal slopes cover one scanline.
+    /// </summary>
+    /// <returns>A pointer to the first of Size() Y1 coordinates</returns>
+    constexpr const i32 *Y1() const { return m_y1.data(); }
+
+    /// <summary>
+    /// Retrieves the array of X coordinate increments per scanline.
+    /// </summary>
+    /// <returns>A pointer to the first of Size() X displacements per scanline (DX)</returns>
+    constexpr const i32 *DX() const { return m_dx.data(); }
+
+    /// <summary>
+    /// Retrieves the array of negative slope flags, each of which is 1 if the slope is negative or 0 otherwise.
+    /// </summary>
+    /// <returns>A pointer to the first of Size() flags</returns>
+    constexpr const u8 *Negative() const { return m_negative.data(); }
+
+    /// <summary>
+    /// Retrieves the array of X-major slope flags, each of which is 1 if the slope is X-major or 0 otherwise.
+    /// </summary>
+    /// <returns>A pointer to the first of Size() flags</returns>
+    constexpr const u8 *XMajor() const { return m_xMajor.data(); }
+
+    /// <summary>
+    /// Computes the spans of every scanline of every slope of the batch into a frame arena.
+    /// </summary>
+    /// <remarks>
+    /// Each slope covers the scanlines from Y0 up to, but excluding, Y1. The starting and ending coordinates of the
+    /// whole batch are each stored in a single allocation, in the order of the slopes, so spans[i + 1].starts directly
+    /// follows the last start of spans[i].
+    /// </remarks>
+    /// <param name="arena">The arena that stores the spans until it is reset</param>
+    /// <param name="spans">The array that receives the spans of each slope, with room for Size() elements</param>
+    /// <returns>true if the spans were generated, false if the arena is out of space</returns>
+    bool GenerateSpans(FrameArena &arena, Spans *spans) const {
+        size_t total = 0;
+        for (size_t i = 0; i < m_count; i++) {
+            total += (size_t)(m_y1[i] - m_y0[i]);
+        }
+        i32 *starts = arena.Allocate<i32>(total);
+        i32 *ends = arena.Allocate<i32>(total);
+        if (starts == nullptr || ends == nullptr) {
+            return false;
+        }
+
+        for (size_t i = 0; i < m_count; i++) {
+            const i32 lines = m_y1[i] - m_y0[i];
+            Get(i).GenerateSpans(m_y0[i], m_y1[i], starts, ends);
+            spans[i] = {starts, ends, m_y0[i], lines};
+            starts += lines;
+            ends += lines;
+        }
+        return true;
+    }
+
+private:
+    using u32 = uint32_t;
+
+    // This is Slope::Setup with every branch replaced by a select. If TableOnly is true, every Y coordinate delta must
+    // be covered by the reciprocal table, which leaves no branches for the division.
+    template <bool TableOnly>
+    constexpr void SetupEdges(const i32 *x0, const i32 *y0, const i32 *x1, const i32 *y1, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            // Always interpolate top to bottom
+            const bool swapped = (y1[i] < y0[i]);
+            const i32 topX = swapped ? x1[i] : x0[i];
+            const i32 topY = swapped ? y1[i] : y0[i];
+            const i32 bottomX = swapped ? x0[i] : x1[i];
+            const i32 bottomY = swapped ? y0[i] : y1[i];
+
+            // Determine if this is a negative slope and if the slope is X-major
+            const bool negative = (bottomX < topX);
+            const i32 dx = negative ? (topX - bottomX) : (bottomX - topX);
+            const i32 dy = bottomY - topY;
+            const bool xMajor = (dx > dy);
+
+            // Adjust X0 for negative slopes and apply the bias for X-major or diagonal slopes
+            const i32 bias = (xMajor || dx == dy) ? Slope::kBias : 0;
+            const i32 x = topX << Slope::kFracBits;
+            m_x0[i] = negative ? (x - 1 - bias) : (x + bias);
+            m_y0[i] = topY;
+            m_y1[i] = (bottomY == topY) ? (topY + 1) : bottomY;
+
+            // Compute X displacement per scanline
+            i32 displacement = dx;
+            if constexpr (TableOnly) {
+                displacement *= Slope::kReciprocal[dy];
+            } else {
+                displacement *= Slope::Reciprocal(dy);
+            }
+            m_dx[i] = displacement;
+        }
+    }
+
+    size_t m_count = 0;                    // Number of configured slopes
+    std::array<i32, Capacity> m_x0{};      // X0 coordinates (minus 1 on negative slopes)
+    std::array<i32, Capacity> m_y0{};      // Y0 coordinates
+    std::array<i32, Capacity> m_y1{};      // Y coordinates past the last scanline
+    std::array<i32, Capacity> m_dx{};      // X displacements per scanline
+    std::array<u8, Capacity> m_negative{}; // 1 if the slope is negative (X1 < X0)
+    std::array<u8, Capacity> m_xMajor{};   // 1 if the slope is X-major (X1-X0 > Y1-Y0)
+};
@@ -0,0 +1,127 @@
+#ifndef SLOPE_KERNEL_H
+#define SLOPE_KERNEL_H
+
+// This file is compiled both as C++ and as GLSL by shaders/slope_spans.comp, which defines SLOPE_KERNEL_GLSL before
+// including it, so it must stay within the common subset of both languages: no references, pointers, templates,
+// constructors or standard library, and only 32-bit int arithmetic. Every operation on int wraps around in GLSL and is
+// well-defined in C++ within the coordinate range supported by Slope, so both languages compute identical results.
+
+#ifdef SLOPE_KERNEL_GLSL
+#define SLOPE_KERNEL_FN
+#else
+#define SLOPE_KERNEL_FN inline
+#endif
+
+/// <summary>
+/// The number of fractional bits of the interpolator, matching Slope::kFracBits.
+/// </summary>
+const int kSlopeKernelFracBits = 18;
+
+/// <summary>
+/// The value 1.0 with fractional bits, matching Slope::kOne.
+/// </summary>
+const int kSlopeKernelOne = 1 << kSlopeKernelFracBits;
+
+/// <summary>
+/// The bias applied to the interpolation of X-major spans, matching Slope::kBias.
+/// </summary>
+const int kSlopeKernelBias = kSlopeKernelOne >> 1;
+
+/// <summary>
+/// The fractional bits discarded from the ends of X-major spans, the complement of Slope::kMask.
+/// </summary>
+const int kSlopeKernelMaskedBits = (1 << (kSlopeKernelFracBits / 2)) - 1;
+
+/// <summary>
+/// An edge in the input buffer of the compute shader, laid out as a std430 structure.
+/// </summary>
+struct SlopeKernelEdge {
+    int x0;        // First X coordinate
+    int y0;        // First Y coordinate
+    int x1;        // Second X coordinate
+    int y1;        // Second Y coordinate
+    int firstSpan; // Index of the first span of the edge in the output buffer
+    int lines;     // Number of scanlines of the edge, from the top endpoint up to, but excluding, the bottom endpoint
+};
+
+/// <summary>
+/// A span in the output buffer of the compute shader, laid out as a std430 structure.
+/// </summary>
+struct SlopeKernelSpan {
+    int start; // Starting X screen coordinate, identical to Slope::XStart (the rightmost pixel on negative slopes)
+    int end;   // Ending X screen coordinate, identical to Slope::XEnd
+};
+
+/// <summary>
+/// The parameters of a slope, identical to those computed by Slope::Setup.
+/// </summary>
+struct SlopeKernelParams {
+    int x0;        // X0 coordinate (adjusted for bias and negative slopes)
+    int y0;        // Y0 coordinate of the top endpoint
+    int dx;        // X displacement per scanline
+    bool negative; // True if the slope is negative (X1 < X0)
+    bool xMajor;   // True if the slope is X-major (X1-X0 > Y1-Y0)
+};
+
+/// <summary>
+/// Configures a slope to interpolate the line (X0,Y0)-(X1,Y1). See Slope::Setup.
+/// </summary>
+SLOPE_KERNEL_FN SlopeKernelParams SlopeKernelSetup(int x0, int y0, int x1, int y1) {
+    // Always interpolate top to bottom
+    if (y1 < y0) {
+        int temp = x0;
+        x0 = x1;
+        x1 = temp;
+        temp = y0;
+        y0 = y1;
+        y1 = temp;
+    }
+
+    SlopeKernelParams slope;
+    slope.x0 = x0 * kSlopeKernelOne;
+    slope.y0 = y0;
+
+    // Negative slopes are offset by one raw unit and interpolated from the other endpoint
+    slope.negative = (x1 < x0);
+    if (slope.negative) {
+        slope.x0 -= 1;
+        int temp = x0;
+        x0 = x1;
+        x1 = temp;
+    }
+
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+    slope.xMajor = (dx > dy);
+    if (slope.xMajor || dx == dy) {
+        slope.x0 += slope.negative ? -kSlopeKernelBias : kSlopeKernelBias;
+    }
+
+    // The reciprocal is computed first, exactly like the hardware. Horizontal lines are interpolated as if dy was 1.
+    slope.dx = dx * (kSlopeKernelOne / ((dy > 0) ? dy : 1));
+    return slope;
+}
+
+/// <summary>
+/// Computes the span of a slope at the specified Y coordinate as screen coordinates. See Slope::XStart and XEnd.
+/// </summary>
+SLOPE_KERNEL_FN SlopeKernelSpan SlopeKernelSpanAt(SlopeKernelParams slope, int y) {
+    int displacement = (y - slope.y0) * slope.dx;
+    int start = slope.negative ? (slope.x0 - displacement) : (slope.x0 + displacement);
+
+    int end = start;
+    if (slope.xMajor) {
+        if (slope.negative) {
+            end = start + (kSlopeKernelMaskedBits - (start & kSlopeKernelMaskedBits)) - slope.dx + kSlopeKernelOne;
+        } else {
+            end = (start & ~kSlopeKernelMaskedBits) + slope.dx - kSlopeKernelOne;
+        }
+    }
+
+    SlopeKernelSpan span;
+    span.start = start >> kSlopeKernelFracBits;
+    span.end = end >> kSlopeKernelFracBits;
+    return span;
+}
+
+#endif // SLOPE_KERNEL_H
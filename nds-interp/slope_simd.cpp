@@ -0,0 +1,235 @@
+#include "slope_simd.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define SLOPE_SIMD_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define SLOPE_SIMD_NEON
+    #include <arm_neon.h>
+#endif
+
+// Enables an instruction set for a single function. MSVC allows intrinsics anywhere, so it needs no annotation.
+#if defined(__GNUC__) || defined(__clang__)
+    #define SLOPE_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define SLOPE_SIMD_TARGET(isa)
+#endif
+
+using u32 = uint32_t;
+using i32 = int32_t;
+
+namespace {
+
+// Every kernel below evaluates the same formulas as Slope::Oriented, rewritten for packed 32-bit integer lanes:
+//
+//   start[i] = start[0] + i * step            (step = -DX on negative slopes, +DX otherwise)
+//   end[i]   = (start[i] & mask) + DX - 1.0   (positive X-major slopes)
+//   end[i]   = (start[i] | ~mask) - DX + 1.0  (negative X-major slopes)
+//   end[i]   = start[i]                       (Y-major slopes)
+//
+// The negative X-major form is equivalent to the x + (~mask - (x & ~mask)) sequence used by Slope: adding ~mask and
+// subtracting the low bits leaves the high bits intact and sets all of the low bits. All additions wrap around exactly
+// like the scalar code, so the results are bit-identical. Each kernel returns the number of scanlines it processed;
+// the remainder is computed by the scalar code.
+
+constexpr u32 kFracBits = Slope::kFracBits;
+constexpr i32 kOne = (i32)Slope::kOne;
+constexpr i32 kMask = (i32)Slope::kMask;
+
+// The kernels only outrun the scalar code on ranges of at least this many scanlines, on slopes of either orientation.
+// Shorter ranges spend most of their time setting up the vectors and in the scalar remainder, whose length varies from
+// one slope to the next, which costs branch mispredictions. X-major slopes are usually short enough to fall under this
+// limit.
+constexpr i32 kMinKernelLines = 32;
+
+#ifdef SLOPE_SIMD_X86
+
+bool CPUSupportsSSE41() {
+    #if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+    #else
+    return __builtin_cpu_supports("sse4.1");
+    #endif
+}
+
+bool CPUSupportsAVX2() {
+    #if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // The OS must save the YMM registers on context switches (OSXSAVE + AVX, then XCR0 bits 1 and 2)
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+    #else
+    return __builtin_cpu_supports("avx2");
+    #endif
+}
+
+template <bool Negative, bool XMajor>
+SLOPE_SIMD_TARGET("sse4.1")
+i32 SpansSSE41(i32 start, i32 dx, i32 count, i32 *starts, i32 *ends) {
+    const i32 step = Negative ? (i32)(0u - (u32)dx) : dx;
+    const __m128i mask = _mm_set1_epi32(Negative ? ~kMask : kMask);
+    const __m128i endOffset = _mm_set1_epi32(Negative ? (i32)((u32)kOne - (u32)dx) : (i32)((u32)dx - (u32)kOne));
+    const __m128i increment = _mm_set1_epi32((i32)((u32)step * 4u));
+    __m128i x = _mm_add_epi32(_mm_set1_epi32(start), _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(step)));
+
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i end = x;
+        if constexpr (XMajor) {
+            if constexpr (Negative) {
+                end = _mm_add_epi32(_mm_or_si128(x, mask), endOffset);
+            } else {
+                end = _mm_add_epi32(_mm_and_si128(x, mask), endOffset);
+            }
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&starts[i]), _mm_srai_epi32(x, kFracBits));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&ends[i]), _mm_srai_epi32(end, kFracBits));
+        x = _mm_add_epi32(x, increment);
+    }
+    return i;
+}
+
+template <bool Negative, bool XMajor>
+SLOPE_SIMD_TARGET("avx2")
+i32 SpansAVX2(i32 start, i32 dx, i32 count, i32 *starts, i32 *ends) {
+    const i32 step = Negative ? (i32)(0u - (u32)dx) : dx;
+    const __m256i mask = _mm256_set1_epi32(Negative ? ~kMask : kMask);
+    const __m256i endOffset = _mm256_set1_epi32(Negative ? (i32)((u32)kOne - (u32)dx) : (i32)((u32)dx - (u32)kOne));
+    const __m256i increment = _mm256_set1_epi32((i32)((u32)step * 8u));
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i x = _mm256_add_epi32(_mm256_set1_epi32(start), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(step)));
+
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i end = x;
+        if constexpr (XMajor) {
+            if constexpr (Negative) {
+                end = _mm256_add_epi32(_mm256_or_si256(x, mask), endOffset);
+            } else {
+                end = _mm256_add_epi32(_mm256_and_si256(x, mask), endOffset);
+            }
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&starts[i]), _mm256_srai_epi32(x, kFracBits));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&ends[i]), _mm256_srai_epi32(end, kFracBits));
+        x = _mm256_add_epi32(x, increment);
+    }
+    return i;
+}
+
+#endif // SLOPE_SIMD_X86
+
+#ifdef SLOPE_SIMD_NEON
+
+template <bool Negative, bool XMajor>
+i32 SpansNEON(i32 start, i32 dx, i32 count, i32 *starts, i32 *ends) {
+    const i32 step = Negative ? (i32)(0u - (u32)dx) : dx;
+    const int32x4_t mask = vdupq_n_s32(Negative ? ~kMask : kMask);
+    const int32x4_t endOffset = vdupq_n_s32(Negative ? (i32)((u32)kOne - (u32)dx) : (i32)((u32)dx - (u32)kOne));
+    const int32x4_t increment = vdupq_n_s32((i32)((u32)step * 4u));
+    const i32 lanes[4] = {0, 1, 2, 3};
+    int32x4_t x = vmlaq_n_s32(vdupq_n_s32(start), vld1q_s32(lanes), step);
+
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32x4_t end = x;
+        if constexpr (XMajor) {
+            if constexpr (Negative) {
+                end = vaddq_s32(vorrq_s32(x, mask), endOffset);
+            } else {
+                end = vaddq_s32(vandq_s32(x, mask), endOffset);
+            }
+        }
+        vst1q_s32(&starts[i], vshrq_n_s32(x, kFracBits));
+        vst1q_s32(&ends[i], vshrq_n_s32(end, kFracBits));
+        x = vaddq_s32(x, increment);
+    }
+    return i;
+}
+
+#endif // SLOPE_SIMD_NEON
+
+} // namespace
+
+SIMDKernel DetectSIMDKernel() {
+    static const SIMDKernel kernel = [] {
+#if defined(SLOPE_SIMD_X86)
+        if (CPUSupportsAVX2()) return SIMDKernel::AVX2;
+        if (CPUSupportsSSE41()) return SIMDKernel::SSE41;
+#elif defined(SLOPE_SIMD_NEON)
+        return SIMDKernel::NEON;
+#endif
+        return SIMDKernel::Scalar;
+    }();
+    return kernel;
+}
+
+bool IsSIMDKernelSupported(SIMDKernel kernel) {
+    switch (kernel) {
+    case SIMDKernel::Scalar: return true;
+#if defined(SLOPE_SIMD_X86)
+    case SIMDKernel::SSE41: return CPUSupportsSSE41();
+    case SIMDKernel::AVX2: return CPUSupportsAVX2();
+#elif defined(SLOPE_SIMD_NEON)
+    case SIMDKernel::NEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+const char *SIMDKernelName(SIMDKernel kernel) {
+    switch (kernel) {
+    case SIMDKernel::Scalar: return "Scalar";
+    case SIMDKernel::SSE41: return "SSE4.1";
+    case SIMDKernel::AVX2: return "AVX2";
+    case SIMDKernel::NEON: return "NEON";
+    default: return "Unknown";
+    }
+}
+
+void GenerateSpansSIMD(const Slope &slope, i32 y0, i32 y1, i32 *starts, i32 *ends) {
+    if (y1 - y0 < kMinKernelLines) {
+        slope.GenerateSpans(y0, y1, starts, ends);
+    } else {
+        GenerateSpansSIMD(DetectSIMDKernel(), slope, y0, y1, starts, ends);
+    }
+}
+
+void GenerateSpansSIMD(SIMDKernel kernel, const Slope &slope, i32 y0, i32 y1, i32 *starts, i32 *ends) {
+    slope.Dispatch([&](auto oriented) {
+        constexpr bool negative = decltype(oriented)::kNegative;
+        constexpr bool xMajor = decltype(oriented)::kXMajor;
+
+        const i32 count = y1 - y0;
+        const i32 start = oriented.FracXStart(y0);
+        const i32 dx = oriented.DX();
+
+        i32 done = 0;
+        switch (kernel) {
+#if defined(SLOPE_SIMD_X86)
+        case SIMDKernel::SSE41: done = SpansSSE41<negative, xMajor>(start, dx, count, starts, ends); break;
+        case SIMDKernel::AVX2: done = SpansAVX2<negative, xMajor>(start, dx, count, starts, ends); break;
+#elif defined(SLOPE_SIMD_NEON)
+        case SIMDKernel::NEON: done = SpansNEON<negative, xMajor>(start, dx, count, starts, ends); break;
+#endif
+        default: break;
+        }
+
+        // Compute the remaining scanlines with the scalar code, which counts them separately
+        NDS_INTERP_COUNT(Spans, done);
+        oriented.GenerateSpans(y0 + done, y1, starts + done, ends + done);
+    });
+}
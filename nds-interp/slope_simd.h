@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "slope.h"
+
+/// <summary>
+/// Instruction sets used by the vectorized span generator.
+/// </summary>
+enum class SIMDKernel {
+    Scalar, // Portable scalar code (Slope::GenerateSpans)
+    SSE41,  // x86 SSE4.1, 4 scanlines per iteration
+    AVX2,   // x86 AVX2, 8 scanlines per iteration
+    NEON,   // ARM NEON, 4 scanlines per iteration
+};
+
+/// <summary>
+/// Determines the fastest span generation kernel supported by the host CPU.
+/// </summary>
+/// <remarks>
+/// The CPU is queried only once; subsequent calls return the cached result.
+/// </remarks>
+/// <returns>The fastest kernel available on this CPU</returns>
+SIMDKernel DetectSIMDKernel();
+
+/// <summary>
+/// Determines if the specified kernel can be used on the host CPU.
+/// </summary>
+/// <param name="kernel">The kernel to check</param>
+/// <returns>true if the kernel was compiled in and the CPU supports its instruction set.</returns>
+bool IsSIMDKernelSupported(SIMDKernel kernel);
+
+/// <summary>
+/// Retrieves the name of a kernel, for display purposes.
+/// </summary>
+/// <param name="kernel">The kernel</param>
+/// <returns>A human-readable name of the kernel</returns>
+const char *SIMDKernelName(SIMDKernel kernel);
+
+/// <summary>
+/// Computes the spans of a range of scanlines as screen coordinates using the fastest code for the slope.
+/// </summary>
+/// <remarks>
+/// The results are bit-identical to Slope::GenerateSpans; see that function for a description of the parameters.
+///
+/// Ranges of at least 32 scanlines are computed with the fastest kernel supported by the CPU (see DetectSIMDKernel).
+/// Shorter ranges, which include most X-major slopes, are computed with Slope::GenerateSpans, which is faster for them.
+/// </remarks>
+/// <param name="slope">The slope to interpolate</param>
+/// <param name="y0">The Y coordinate of the first scanline, between Y0 and Y1 specified in Setup</param>
+/// <param name="y1">The Y coordinate past the last scanline, not past Y1 specified in Setup</param>
+/// <param name="starts">The array that receives the starting X screen coordinates of the spans</param>
+/// <param name="ends">The array that receives the ending X screen coordinates of the spans</param>
+void GenerateSpansSIMD(const Slope &slope, int32_t y0, int32_t y1, int32_t *starts, int32_t *ends);
+
+/// <summary>
+/// Computes the spans of a range of scanlines as screen coordinates using the specified kernel.
+/// </summary>
+/// <remarks>
+/// The kernel must be supported by the CPU (see IsSIMDKernelSupported).
+/// </remarks>
+/// <param name="kernel">The kernel to use</param>
+/// <param name="slope">The slope to interpolate</param>
+/// <param name="y0">The Y coordinate of the first scanline, between Y0 and Y1 specified in Setup</param>
+/// <param name="y1">The Y coordinate past the last scanline, not past Y1 specified in Setup</param>
+/// <param name="starts">The array that receives the starting X screen coordinates of the spans</param>
+/// <param name="ends">The array that receives the ending X screen coordinates of the spans</param>
+void GenerateSpansSIMD(SIMDKernel kernel, const Slope &slope, int32_t y0, int32_t y1, int32_t *starts,
+                       int32_t *ends);
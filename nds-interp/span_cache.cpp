@@ -0,0 +1,116 @@
+#include "span_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include "slope.h"
+
+namespace {
+
+// Packs the endpoints of an edge into a key. Returns false if a coordinate does not fit in 16 bits.
+bool PackKey(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint64_t &key) {
+    for (int32_t coord : {x0, y0, x1, y1}) {
+        if (coord < INT16_MIN || coord > INT16_MAX) {
+            return false;
+        }
+    }
+    key = (uint64_t)(uint16_t)x0 | ((uint64_t)(uint16_t)y0 << 16) | ((uint64_t)(uint16_t)x1 << 32) |
+          ((uint64_t)(uint16_t)y1 << 48);
+    return true;
+}
+
+// Mixes the bits of a key so that edges with nearby endpoints land on distant entries
+uint64_t Hash(uint64_t key) {
+    key ^= key >> 29;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 32;
+    return key;
+}
+
+} // namespace
+
+SpanCache::SpanCache(size_t capacity) {
+    size_t size = kProbes;
+    while (size < capacity) {
+        size *= 2;
+    }
+    m_entries.resize(size);
+    m_starts.resize(size * kMaxLines);
+    m_ends.resize(size * kMaxLines);
+    m_mask = size - 1;
+}
+
+bool SpanCache::Get(i32 x0, i32 y0, i32 x1, i32 y1, Edge &edge) {
+    // Always interpolate top to bottom, like Slope::Setup
+    if (y1 < y0) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    u64 key;
+    const i32 lines = std::max(y1 - y0, 1);
+    if (lines > kMaxLines || !PackKey(x0, y0, x1, y1, key)) {
+        m_stats.bypasses++;
+        return false;
+    }
+
+    // Look for the edge within the probe window, picking the entry unused for the longest time as the replacement.
+    // Entries are never removed individually, so the edge cannot be past an empty entry.
+    const size_t start = Hash(key) & m_mask;
+    size_t victim = m_entries.size();
+    u32 victimAge = 0;
+    for (size_t i = 0; i < kProbes; i++) {
+        const size_t index = (start + i) & m_mask;
+        Entry &entry = m_entries[index];
+        if (entry.lines == 0) {
+            victim = index;
+            break;
+        }
+        if (entry.key == key) {
+            m_stats.hits++;
+            entry.lastFrame = m_frame;
+            edge = {&m_starts[index * kMaxLines], &m_ends[index * kMaxLines], entry.y0, entry.lines, entry.negative};
+            return true;
+        }
+        const u32 age = m_frame - entry.lastFrame;
+        if (age > victimAge) {
+            victim = index;
+            victimAge = age;
+        }
+    }
+    if (victim == m_entries.size()) {
+        // Every probed entry is in use during this frame
+        m_stats.bypasses++;
+        return false;
+    }
+
+    Entry &entry = m_entries[victim];
+    m_stats.misses++;
+    if (entry.lines != 0) {
+        m_stats.evictions++;
+    }
+
+    Slope slope;
+    slope.Setup(x0, y0, x1, y1);
+    i32 *starts = &m_starts[victim * kMaxLines];
+    i32 *ends = &m_ends[victim * kMaxLines];
+    slope.GenerateSpans(y0, y0 + lines, starts, ends);
+
+    entry.key = key;
+    entry.lastFrame = m_frame;
+    entry.y0 = y0;
+    entry.lines = lines;
+    entry.negative = slope.IsNegative();
+    edge = {starts, ends, y0, lines, entry.negative};
+    return true;
+}
+
+void SpanCache::Clear() {
+    std::fill(m_entries.begin(), m_entries.end(), Entry{});
+}
+
+double SpanCache::HitRate() const {
+    const u64 lookups = m_stats.hits + m_stats.misses + m_stats.bypasses;
+    return (lookups != 0) ? (double)m_stats.hits / lookups : 0.0;
+}
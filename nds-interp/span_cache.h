@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Caches the spans of slopes across frames, keyed by their endpoints.
+/// </summary>
+/// <remarks>
+/// Games redraw mostly static geometry every frame, so the same edges are set up and interpolated over and over. The
+/// cache stores the spans generated for each edge in a fixed-size, open-addressed table indexed by a hash of the packed
+/// endpoints, so a repeated edge skips both Slope::Setup and span generation.
+///
+/// The table is allocated once by the constructor. Each entry holds the spans of up to kMaxLines scanlines, taking
+/// about 1.5 KB, and records the last frame in which it was used. Lookups probe a small window of entries; when an edge
+/// is not found, it replaces the entry in the window that has gone unused for the longest time. Entries used during the
+/// current frame are never replaced, so the spans returned by Get remain valid until NextFrame is called. If every
+/// entry in the window was used during the current frame, the edge is not cached and Get fails.
+///
+/// Call NextFrame once per frame. The statistics count hits, misses and evictions, so the hit rate of a given workload
+/// can be measured to decide whether the cache pays off.
+/// </remarks>
+class SpanCache {
+    using u32 = uint32_t;
+    using u64 = uint64_t;
+    using i32 = int32_t;
+
+public:
+    /// <summary>
+    /// The maximum number of scanlines of a cached edge, which covers every edge on the 256x192 screen.
+    /// </summary>
+    static constexpr i32 kMaxLines = 192;
+
+    /// <summary>
+    /// The default number of entries of the table.
+    /// </summary>
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    /// <summary>
+    /// The number of entries probed by each lookup.
+    /// </summary>
+    static constexpr size_t kProbes = 8;
+
+    /// <summary>
+    /// The spans of a cached edge.
+    /// </summary>
+    struct Edge {
+        const i32 *starts; // Starting X screen coordinates of each scanline, identical to Slope::XStart
+        const i32 *ends;   // Ending X screen coordinates of each scanline, identical to Slope::XEnd
+        i32 y0;            // Y coordinate of the first scanline
+        i32 lines;         // Number of scanlines
+        bool negative;     // Whether the slope is negative, in which case the spans are reversed like Slope's
+    };
+
+    /// <summary>
+    /// Cache usage statistics.
+    /// </summary>
+    struct Stats {
+        u64 hits = 0;      // Lookups that found the edge in the cache
+        u64 misses = 0;    // Lookups that generated the spans of the edge
+        u64 evictions = 0; // Misses that replaced another edge
+        u64 bypasses = 0;  // Edges that could not be cached because they are too tall or the probed entries are busy
+    };
+
+    /// <summary>
+    /// Creates a cache with the specified number of entries.
+    /// </summary>
+    /// <param name="capacity">The number of entries, rounded up to a power of two</param>
+    explicit SpanCache(size_t capacity = kDefaultCapacity);
+
+    /// <summary>
+    /// Retrieves the spans of the slope (X0,Y0)-(X1,Y1), generating and caching them if the edge is not cached yet.
+    /// </summary>
+    /// <remarks>
+    /// The edge covers the same scanlines as Slope: from the top endpoint up to, but excluding, the bottom endpoint, or
+    /// a single scanline for horizontal edges. Both directions of an edge share the same entry. The spans remain valid
+    /// until the next call to NextFrame or Clear.
+    /// </remarks>
+    /// <param name="x0">First X coordinate</param>
+    /// <param name="y0">First Y coordinate</param>
+    /// <param name="x1">Second X coordinate</param>
+    /// <param name="y1">Second Y coordinate</param>
+    /// <param name="edge">Receives the spans of the edge</param>
+    /// <returns>true if the spans were retrieved, false if the edge cannot be cached</returns>
+    bool Get(i32 x0, i32 y0, i32 x1, i32 y1, Edge &edge);
+
+    /// <summary>
+    /// Advances to the next frame, allowing the entries used during the current frame to be replaced.
+    /// </summary>
+    void NextFrame() { m_frame++; }
+
+    /// <summary>
+    /// Removes every edge from the cache. The statistics are kept.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Retrieves the usage statistics accumulated since the cache was created or the statistics were reset.
+    /// </summary>
+    /// <returns>The usage statistics</returns>
+    const Stats &GetStats() const { return m_stats; }
+
+    /// <summary>
+    /// Resets the usage statistics.
+    /// </summary>
+    void ResetStats() { m_stats = {}; }
+
+    /// <summary>
+    /// Computes the fraction of lookups that found the edge in the cache.
+    /// </summary>
+    /// <returns>The hit rate between 0 and 1, or 0 if there were no lookups</returns>
+    double HitRate() const;
+
+    /// <summary>
+    /// Retrieves the number of entries of the table.
+    /// </summary>
+    /// <returns>The number of entries</returns>
+    size_t Capacity() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        u64 key = 0;        // Packed endpoints, top to bottom
+        u32 lastFrame = 0;  // Frame in which the entry was last used
+        i32 y0 = 0;         // Y coordinate of the first scanline
+        i32 lines = 0;      // Number of scanlines, or zero if the entry is empty
+        bool negative = false;
+    };
+
+    std::vector<Entry> m_entries; // Entries of the table
+    std::vector<i32> m_starts;    // Starting coordinates of the spans of entry i at [i * kMaxLines]
+    std::vector<i32> m_ends;      // Ending coordinates of the spans of entry i at [i * kMaxLines]
+    size_t m_mask;                // Mask applied to hashes to obtain an entry index
+    u32 m_frame = 1;              // Current frame
+    Stats m_stats;                // Usage statistics
+};
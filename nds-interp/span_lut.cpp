@@ -0,0 +1,101 @@
+#include "span_lut.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = {'N', 'D', 'S', 'L'};
+
+void WriteU32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)(value >> 0);
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+uint32_t ReadU32(const uint8_t *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+} // namespace
+
+bool SpanLUT::Generate(const std::filesystem::path &path) {
+    std::vector<u8> buffer(kHeaderSize + kTotalLines * 2);
+
+    u8 *header = buffer.data();
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    WriteU32(header + 4, kVersion);
+    WriteU32(header + 8, Slope::kFracBits);
+    WriteU32(header + 12, kMaxDX);
+    WriteU32(header + 16, kMaxDY);
+    WriteU32(header + 20, kTotalLines);
+
+    u8 *spans = buffer.data() + kHeaderSize;
+    for (i32 dx = 0; dx <= kMaxDX; dx++) {
+        for (i32 dy = 0; dy <= kMaxDY; dy++) {
+            // Horizontal slopes are rasterized as a single scanline
+            const i32 lines = (dy == 0) ? 1 : dy;
+
+            Slope slope;
+            slope.Setup(0, 0, dx, dy);
+
+            u8 *out = &spans[FirstLine(dx, dy) * 2];
+            for (i32 y = 0; y < lines; y++) {
+                const i32 start = slope.XStart(y);
+                const i32 length = slope.XEnd(y) - start;
+                if (start < 0 || start > 255 || length < 0 || length > 255) {
+                    // Cannot be represented in the file format
+                    return false;
+                }
+                *out++ = (u8)start;
+                *out++ = (u8)length;
+            }
+        }
+    }
+
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out.write((const char *)buffer.data(), buffer.size());
+    return out.good();
+}
+
+bool SpanLUT::Open(const std::filesystem::path &path) {
+    if (!m_file.Open(path)) {
+        return false;
+    }
+
+    const u8 *header = m_file.Data();
+    if (m_file.Size() != kHeaderSize + kTotalLines * 2 || std::memcmp(header, kMagic, sizeof(kMagic)) != 0 ||
+        ReadU32(header + 4) != kVersion || ReadU32(header + 8) != Slope::kFracBits ||
+        ReadU32(header + 12) != (u32)kMaxDX || ReadU32(header + 16) != (u32)kMaxDY ||
+        ReadU32(header + 20) != kTotalLines) {
+        m_file.Close();
+        return false;
+    }
+    return true;
+}
+
+bool SpanLUT::Setup(i32 x0, i32 y0, i32 x1, i32 y1, Edge &edge) const {
+    if (!m_file.IsOpen() || !Covers(x0, y0, x1, y1)) {
+        return false;
+    }
+
+    // Always interpolate top to bottom
+    if (y1 < y0) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    const bool negative = (x1 < x0);
+    const i32 dx = negative ? (x0 - x1) : (x1 - x0);
+    const i32 dy = y1 - y0;
+
+    edge.m_spans = m_file.Data() + kHeaderSize + FirstLine(dx, dy) * 2;
+    edge.m_x0 = x0;
+    edge.m_y0 = y0;
+    edge.m_lines = (dy == 0) ? 1 : dy;
+    edge.m_negative = negative;
+    return true;
+}
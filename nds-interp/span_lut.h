@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "mapped_file.h"
+#include "slope.h"
+
+/// <summary>
+/// Serves the spans of every slope that fits on the Nintendo DS screen from a precomputed, memory-mapped table.
+/// </summary>
+/// <remarks>
+/// Spans only depend on the deltas between the endpoints of a slope: offsetting X0 by an integer amount offsets every
+/// span by the same amount, and negative slopes mirror their positive counterparts exactly (a negative span starts at
+/// X0 - 1 - S and ends at X0 - 1 - E, where S and E are the offsets of the positive span). The table therefore stores
+/// the spans of positive slopes only, relative to X0, and serves all four screen corners and both directions.
+///
+/// Every slope with 0 &lt;= DX &lt;= kMaxDX and 0 &lt;= DY &lt;= kMaxDY is covered. Each slope has max(DY, 1)
+/// scanlines, as horizontal slopes are rasterized as a single scanline, and each scanline is stored as two bytes: the
+/// offset of the start of the span relative to X0 and the length of the span minus one.
+///
+/// The file consists of a header followed by the spans of every slope, ordered by DX then DY:
+///
+///    Offset  Size  Contents
+///    0       4     Magic "NDSL"
+///    4       4     Format version (kVersion)
+///    8       4     Number of fractional bits of the interpolator (Slope::kFracBits)
+///    12      4     Maximum DX (kMaxDX)
+///    16      4     Maximum DY (kMaxDY)
+///    20      4     Total number of scanlines N
+///    24      2*N   (start offset, length - 1) pairs
+///
+/// All values are little-endian.
+/// </remarks>
+class SpanLUT {
+    using u8 = uint8_t;
+    using u32 = uint32_t;
+    using i32 = int32_t;
+
+public:
+    /// <summary>
+    /// The current version of the file format.
+    /// </summary>
+    static constexpr u32 kVersion = 1;
+
+    /// <summary>
+    /// The largest X coordinate delta covered by the table.
+    /// </summary>
+    static constexpr i32 kMaxDX = 256;
+
+    /// <summary>
+    /// The largest Y coordinate delta covered by the table.
+    /// </summary>
+    static constexpr i32 kMaxDY = 192;
+
+    /// <summary>
+    /// The size of the file header in bytes.
+    /// </summary>
+    static constexpr size_t kHeaderSize = 24;
+
+    /// <summary>
+    /// A slope whose spans are served from the table.
+    /// </summary>
+    class Edge {
+    public:
+        /// <summary>
+        /// Retrieves the starting position of the span at the specified Y coordinate as a screen coordinate.
+        /// </summary>
+        /// <param name="y">The Y coordinate, which must be within the scanlines of the slope</param>
+        /// <returns>The starting X screen coordinate of the scanline's span, identical to Slope::XStart</returns>
+        i32 XStart(i32 y) const {
+            const i32 offset = m_spans[(y - m_y0) * 2];
+            return m_negative ? (m_x0 - 1 - offset) : (m_x0 + offset);
+        }
+
+        /// <summary>
+        /// Retrieves the ending position of the span at the specified Y coordinate as a screen coordinate.
+        /// </summary>
+        /// <param name="y">The Y coordinate, which must be within the scanlines of the slope</param>
+        /// <returns>The ending X screen coordinate of the scanline's span, identical to Slope::XEnd</returns>
+        i32 XEnd(i32 y) const {
+            const u8 *span = &m_spans[(y - m_y0) * 2];
+            const i32 offset = span[0] + span[1];
+            return m_negative ? (m_x0 - 1 - offset) : (m_x0 + offset);
+        }
+
+        /// <summary>
+        /// Retrieves the Y coordinate of the first scanline of the slope.
+        /// </summary>
+        /// <returns>The topmost Y coordinate of the slope</returns>
+        i32 Y0() const { return m_y0; }
+
+        /// <summary>
+        /// Retrieves the number of scanlines of the slope.
+        /// </summary>
+        /// <returns>The number of scanlines in the table for this slope</returns>
+        i32 Lines() const { return m_lines; }
+
+        /// <summary>
+        /// Determines if the slope is negative (i.e. X decreases as Y increases).
+        /// </summary>
+        /// <returns>true if the slope is negative.</returns>
+        bool IsNegative() const { return m_negative; }
+
+    private:
+        const u8 *m_spans = nullptr; // Spans of the slope in the table
+        i32 m_x0 = 0;                // X0 screen coordinate
+        i32 m_y0 = 0;                // Y0 coordinate
+        i32 m_lines = 0;             // Number of scanlines
+        bool m_negative = false;     // True if the slope is negative (X1 < X0)
+
+        friend class SpanLUT;
+    };
+
+    /// <summary>
+    /// Computes the spans of every covered slope using Slope and writes the table to the specified file.
+    /// </summary>
+    /// <param name="path">The path to the file to write</param>
+    /// <returns>true if the file was written successfully.</returns>
+    static bool Generate(const std::filesystem::path &path);
+
+    /// <summary>
+    /// Maps a table file into memory, closing the previously opened table if there is one.
+    /// </summary>
+    /// <param name="path">The path to the table file</param>
+    /// <returns>true if the file was mapped and its header is valid.</returns>
+    bool Open(const std::filesystem::path &path);
+
+    /// <summary>
+    /// Unmaps the table file.
+    /// </summary>
+    void Close() { m_file.Close(); }
+
+    /// <summary>
+    /// Determines if a table is currently open.
+    /// </summary>
+    /// <returns>true if a table is open.</returns>
+    bool IsOpen() const { return m_file.IsOpen(); }
+
+    /// <summary>
+    /// Determines if the table covers the slope (X0,Y0)-(X1,Y1).
+    /// </summary>
+    /// <param name="x0">First X coordinate</param>
+    /// <param name="y0">First Y coordinate</param>
+    /// <param name="x1">Second X coordinate</param>
+    /// <param name="y1">Second Y coordinate</param>
+    /// <returns>true if the slope's deltas are within the range of the table.</returns>
+    static constexpr bool Covers(i32 x0, i32 y0, i32 x1, i32 y1) {
+        const i32 dx = (x1 < x0) ? (x0 - x1) : (x1 - x0);
+        const i32 dy = (y1 < y0) ? (y0 - y1) : (y1 - y0);
+        return dx <= kMaxDX && dy <= kMaxDY;
+    }
+
+    /// <summary>
+    /// Configures an edge to interpolate the line (X0,Y0)-(X1,Y1) using screen coordinates.
+    /// </summary>
+    /// <remarks>
+    /// The edge covers scanlines min(Y0,Y1) to max(Y0,Y1) - 1, or just min(Y0,Y1) if both Y coordinates are equal.
+    /// The table must be open and must cover the slope (see Covers); otherwise, the edge is left untouched.
+    /// </remarks>
+    /// <param name="x0">First X coordinate</param>
+    /// <param name="y0">First Y coordinate</param>
+    /// <param name="x1">Second X coordinate</param>
+    /// <param name="y1">Second Y coordinate</param>
+    /// <param name="edge">The edge to configure</param>
+    /// <returns>true if the edge was configured.</returns>
+    bool Setup(i32 x0, i32 y0, i32 x1, i32 y1, Edge &edge) const;
+
+private:
+    // Number of scanlines stored for all slopes with the same DX
+    static constexpr u32 kLinesPerDX = 1 + kMaxDY * (kMaxDY + 1) / 2;
+
+    // Total number of scanlines in the table
+    static constexpr u32 kTotalLines = kLinesPerDX * (kMaxDX + 1);
+
+    // Computes the index of the first scanline of the slope with the specified deltas
+    static constexpr u32 FirstLine(i32 dx, i32 dy) {
+        // Slopes with DY = 0 have one scanline and are stored first, followed by DY = 1, 2, ... with DY scanlines each
+        const u32 linesBefore = (dy == 0) ? 0 : 1 + dy * (dy - 1) / 2;
+        return dx * kLinesPerDX + linesBefore;
+    }
+
+    MappedFile m_file; // Mapped table file
+};